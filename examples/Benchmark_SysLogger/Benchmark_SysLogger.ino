@@ -0,0 +1,446 @@
+/*
+**  Program   : Benchmark_SysLogger
+**
+**  Measures the time the ESPSL methods take for a range of depths
+**  and line widths on every storage backend. Results are printed to
+**  Serial as a table: time, seeks and heap use per op and, for the
+**  writes, the bytes written to the file per byte of log text.
+**  Every storage ends with 10k lines: lines per second and, on the
+**  emulated flash, the sector erases per 10k lines.
+**
+**  It also builds and runs on a Linux PC (extras/host: make run-benchmark),
+**  there the seeks are File::seek() calls and the heap calls are counted.
+*/
+#define _FW_VERSION "v2.0.1 (20-12-2022)"
+/*
+**  Copyright (c) 2019 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+#include "ESPSL_Flash.h"
+#include <new>
+#define _FSYS LittleFS
+
+#define _WEARDEPTH      1000    // depth and lineWidth of the 10k lines comparison
+#define _WEARWIDTH       100
+#define _WEARLINES     10000
+
+ESPSL sysLog;                   // Create instance of the ESPSL object
+
+//-- the storage backends to compare
+ESPSL_FSStorage     fsStorage(LittleFS);
+ESPSL_RamStorage    ramStorage(24 * 1024);
+#if defined(ESP32)
+#if defined(ESPSL_HOST)
+ESPSL_PosixStorage  posixStorage(ESPSL_HOST_FS);  // the directory LittleFS is in
+#else
+ESPSL_PosixStorage  posixStorage("/littlefs");
+#endif
+ESPSL_FlashEmulator *flashEmulator = NULL;     // raw flash image in RAM, newFlash()
+ESPSL_FlashStorage  *flashStorage  = NULL;
+#endif
+
+struct backend {
+  const char    *name;
+  ESPSL_Storage *storage;
+  uint32_t       maxBytes;     // 0: free space on LittleFS
+} backends[] = {                // storage NULL: emulated flash sized by newFlash()
+  { "LittleFS", &fsStorage,    0 },
+  { "RAM",      &ramStorage,   (24 * 1024) },
+#if defined(ESP32)
+  { "POSIX",    &posixStorage, 0 },
+  { "Flash",    NULL,          0 },
+#endif
+};
+
+#define writeToSysLog(...) ({ sysLog.writeDbg( sysLog.buildD("(%4d)[%-12.12s(%4d)] "          \
+                                                             , number++                       \
+                                                             , __FUNCTION__, __LINE__)        \
+                                              ,__VA_ARGS__); })
+
+//-- ESPSL debug output (dumpLogFile()) goes nowhere so only the logger is measured
+class NullStream : public Stream
+{
+  public:
+    int     available()             { return 0; }
+    int     read()                  { return -1; }
+    int     peek()                  { return -1; }
+    void    flush()                 { }
+    size_t  write(uint8_t c)        { return 1; }
+    size_t  write(const uint8_t *buf, size_t size) { return size; }
+};
+
+NullStream  nullStream;
+
+const uint16_t  depths[]     = { 10, 100, 1000, 10000 };
+const uint16_t  lineWidths[] = { 50, 100, 150 };
+
+uint32_t  number = 0;
+
+//-------------------------------------------------------------------------
+uint32_t freeFsBytes()
+{
+#if defined(ESP8266)
+  FSInfo fsInfo;
+  _FSYS.info(fsInfo);
+  return (fsInfo.totalBytes - fsInfo.usedBytes);
+#else
+  return (_FSYS.totalBytes() - _FSYS.usedBytes());
+#endif
+
+} // freeFsBytes()
+
+#if defined(ESP32)
+//-------------------------------------------------------------------------
+//-- a new emulated flash for a ring of ringBytes: the two journal sectors,
+//-- the ring and the sector that is erased ahead
+boolean newFlash(uint32_t ringBytes)
+{
+  uint32_t sectors = (2 + ((ringBytes + 4095) / 4096) +1);
+
+  sysLog.setStorage(NULL);
+  delete flashStorage;
+  delete flashEmulator;
+  flashEmulator = new (std::nothrow) ESPSL_FlashEmulator(sectors);
+  flashStorage  = (flashEmulator ? new (std::nothrow) ESPSL_FlashStorage(*flashEmulator) : NULL);
+  if ((flashStorage == NULL) || (flashEmulator->numSectors() != sectors))
+  {
+    Serial.printf("newFlash(): no memory for [%lu] emulated sectors .. skipped!\r\n\n", (unsigned long)sectors);
+    return false;
+  }
+  sysLog.setStorage(flashStorage);
+  return true;
+
+} // newFlash()
+#endif
+
+//-------------------------------------------------------------------------
+bool countLine(uint32_t lineID, uint32_t timeStamp, const char *line, void *ctx)
+{
+  (*(uint32_t*)ctx)++;
+  return true;
+
+} // countLine()
+
+//-------------------------------------------------------------------------
+//-- seeks: File::seek() calls on the PC, reads/writes not where the previous
+//-- one ended on the ESP (ESPSL_stats)
+uint32_t seekCount()
+{
+#if defined(ESPSL_HOST)
+  return hostSeeks();
+#else
+  ESPSL_stats stats;
+  sysLog.getStats(&stats);
+  return stats.seeks;
+#endif
+
+} // seekCount()
+
+//-------------------------------------------------------------------------
+uint32_t bytesWritten()
+{
+  ESPSL_stats stats;
+  sysLog.getStats(&stats);
+  return stats.bytesWritten;
+
+} // bytesWritten()
+
+//-------------------------------------------------------------------------
+struct {
+  uint32_t  micros;
+  uint32_t  seeks;
+  uint32_t  allocs;
+  uint32_t  bytes;
+  int32_t   heap;
+} opStart;
+
+void startOp()
+{
+  opStart.seeks  = seekCount();
+  opStart.bytes  = bytesWritten();
+#if defined(ESPSL_HOST)
+  opStart.allocs = hostAllocs();
+#endif
+  opStart.heap   = ESP.getFreeHeap();
+  opStart.micros = micros();
+
+} // startOp()
+
+//-------------------------------------------------------------------------
+//-- textBytes: chars of log text written by the ops (0: not a write)
+void printResult(const char *what, uint16_t depth, uint16_t lineWidth, uint32_t ops, uint32_t textBytes = 0)
+{
+  uint32_t  elapsedMicros = (micros() - opStart.micros);
+  int32_t   heapUsed      = (opStart.heap - (int32_t)ESP.getFreeHeap());
+  char      perByte[16]   = "";
+
+  if (ops == 0) { ops = 1; }
+  if (textBytes > 0) { snprintf(perByte, sizeof(perByte), "%5.2f", (float)(bytesWritten() - opStart.bytes) / textBytes); }
+  Serial.printf("%-14s depth[%5d] width[%3d] ops[%5d] %10lu ns/op  seeks[%7.2f]"
+                                    , what, depth, lineWidth, ops
+                                    , (unsigned long)(((uint64_t)elapsedMicros * 1000) / ops)
+                                    , (float)(seekCount() - opStart.seeks) / ops);
+#if defined(ESPSL_HOST)
+  Serial.printf(" allocs[%6.2f]", (float)(hostAllocs() - opStart.allocs) / ops);
+#endif
+  Serial.printf(" heap[%6d] bytes/byte[%5s]\r\n", heapUsed, perByte);
+
+} // printResult()
+
+//-------------------------------------------------------------------------
+void benchmark(uint16_t depth, uint16_t lineWidth)
+{
+  const char *writeLine = "-----[ write() ]------------------------------------";
+  char        lLine[200];
+  uint32_t    startCycles, ops, lines, textLen;
+
+  lines = (depth < 1000 ? (2 * depth) : 1000);
+
+  //-- begin() on an empty FS -> create()
+  sysLog.removeSysLog();
+  startOp();
+  sysLog.begin(depth, lineWidth);
+  printResult("begin(create)", depth, lineWidth, 1);
+
+  //-- write()
+  startOp();
+  for(ops = 0; ops < lines; ops++)
+  {
+    sysLog.write(writeLine);
+  }
+  printResult("write()", depth, lineWidth, ops, (ops * strlen(writeLine)));
+  yield();
+
+  //-- writef()
+  textLen = snprintf(lLine, sizeof(lLine), "-----[ %07d ]------[ %04d ]-----------------------------", 0, depth);
+  startOp();
+  for(ops = 0; ops < lines; ops++)
+  {
+    sysLog.writef("-----[ %07d ]------[ %04d ]-----------------------------", ops, depth);
+  }
+  printResult("writef()", depth, lineWidth, ops, (ops * textLen));
+  yield();
+
+  //-- writeDbg() through the writeToSysLog() macro
+  textLen = snprintf(lLine, sizeof(lLine), "(%4d)[%-12.12s(%4d)] FS File: %s, size: %d"
+                                         , (int)number, __FUNCTION__, __LINE__, "/sysLog.dat", depth);
+  startOp();
+  for(ops = 0; ops < lines; ops++)
+  {
+    writeToSysLog("FS File: %s, size: %d", "/sysLog.dat", depth);
+  }
+  printResult("writeDbg()", depth, lineWidth, ops, (ops * textLen));
+  yield();
+
+  //-- CPU cycles per writeToSysLog() line, buffered so it is mostly formatting
+  sysLog.setBuffered(50, 0, 0);
+  startCycles = ESP.getCycleCount();
+  for(ops = 0; ops < lines; ops++)
+  {
+    writeToSysLog("FS File: %s, size: %d", "/sysLog.dat", depth);
+  }
+  Serial.printf("%-14s depth[%5d] width[%3d] ops[%5d] %10lu cycles/line\r\n"
+                                    , "writeDbg(buff)", depth, lineWidth, ops
+                                    , (unsigned long)((ESP.getCycleCount() - startCycles) / ops));
+  sysLog.setBuffered(0, 0, 0);
+  yield();
+
+  //-- begin() on an existing file -> init()
+  startOp();
+  sysLog.begin(depth, lineWidth);
+  printResult("begin(exists)", depth, lineWidth, 1);
+
+  //-- startReading() + readNextLine() over all lines
+  ops = 0;
+  startOp();
+  sysLog.startReading();
+  while( sysLog.readNextLine(lLine, sizeof(lLine)) ) { ops++; }
+  printResult("readNextLine()", depth, lineWidth, ops);
+  yield();
+
+  //-- readLines() over all lines
+  ops = 0;
+  startOp();
+  sysLog.readLines(0, 0, countLine, &ops);
+  printResult("readLines()", depth, lineWidth, ops);
+  yield();
+
+  //-- search with readNextLine() + strstr() over all lines
+  ops = 0;
+  startOp();
+  sysLog.startReading();
+  while( sysLog.readNextLine(lLine, sizeof(lLine)) ) { if (strstr(lLine, "size: 1")) ops++; }
+  printResult("strstr() loop", depth, lineWidth, depth);
+  yield();
+
+  //-- search with find() over all lines
+  ops = 0;
+  startOp();
+  sysLog.find("size: 1", countLine, &ops);
+  printResult("find()", depth, lineWidth, depth);
+  yield();
+
+  //-- readRange() for the last 10 minutes (binary search on the time stamps)
+  ops = 0;
+  startOp();
+  sysLog.readRange(time(NULL) - 600, time(NULL), countLine, &ops);
+  printResult("readRange()", depth, lineWidth, ops);
+  yield();
+
+  //-- dumpLogFile()
+  startOp();
+  sysLog.dumpLogFile();
+  printResult("dumpLogFile()", depth, lineWidth, depth);
+
+  //-- begin() with half the depth -> resizeLog() copies the newest lines
+  startOp();
+  sysLog.begin((depth / 2 < 10 ? 10 : depth / 2), lineWidth);
+  printResult("begin(resize)", depth, lineWidth, (depth / 2));
+  Serial.println();
+
+} // benchmark()
+
+//-------------------------------------------------------------------------
+//-- _WEARLINES lines with write() in a ring of _WEARDEPTH lines: lines per
+//-- second and, on the emulated flash, sector erases per 10k lines
+void wearCompare(uint8_t b)
+{
+  const char *writeLine = "-----[ write() ]------------------------------------";
+  uint32_t    elapsedMicros, ops;
+
+  sysLog.removeSysLog();
+  sysLog.begin(_WEARDEPTH, _WEARWIDTH);
+#if defined(ESP32)
+  if (backends[b].storage == NULL) { flashEmulator->resetCounters(); }
+#endif
+  startOp();
+  for(ops = 0; ops < _WEARLINES; ops++)
+  {
+    sysLog.write(writeLine);
+    if ((ops % 1000) == 999) { yield(); }
+  }
+  elapsedMicros = (micros() - opStart.micros);
+  if (elapsedMicros == 0) { elapsedMicros = 1; }
+  Serial.printf("%-14s depth[%5d] width[%3d] lines[%5d] %8lu lines/sec  bytes/line[%6.1f]"
+                                    , "10k lines", _WEARDEPTH, _WEARWIDTH, ops
+                                    , (unsigned long)(((uint64_t)ops * 1000000) / elapsedMicros)
+                                    , (float)(bytesWritten() - opStart.bytes) / ops);
+#if defined(ESP32)
+  if (backends[b].storage == NULL)
+  {
+    Serial.printf(" %lu sector erases/10k lines"
+                                    , (unsigned long)(((uint64_t)flashEmulator->erases() * 10000) / ops));
+  }
+#endif
+  Serial.print("\r\n\n");
+
+} // wearCompare()
+
+//-------------------------------------------------------------------------
+//-- the system logfile (depth lines of lineWidth) fits on backend b, the
+//-- emulated flash is made to fit
+boolean makeRoom(uint8_t b, uint16_t depth, uint16_t lineWidth)
+{
+  uint32_t needed = sizeof(ESPSL_fileHeader) + ((uint32_t)depth * (lineWidth + sizeof(ESPSL_recHeader)));
+  uint32_t room;
+
+#if defined(ESP32)
+  if (backends[b].storage == NULL) return newFlash(needed - sizeof(ESPSL_fileHeader));
+#endif
+  room = (backends[b].maxBytes ? backends[b].maxBytes : freeFsBytes());
+  if (needed > (room / 2))
+  {
+    Serial.printf("skip depth[%5d] width[%3d]: needs [%d] bytes on %s\r\n\n", depth, lineWidth, needed, backends[b].name);
+    return false;
+  }
+  return true;
+
+} // makeRoom()
+
+//-------------------------------------------------------------------------
+void setup()
+{
+  Serial.begin(115200);
+  Serial.printf("\r\nBenchmark ESP System Logger %s\r\n\n", _FW_VERSION);
+
+#if defined(ESP8266)
+  _FSYS.begin();
+#else
+  _FSYS.begin(true);
+#endif
+
+  sysLog.setOutput(&nullStream);
+  sysLog.setDebugLvl(0);
+
+  for (uint8_t b = 0; b < (sizeof(backends) / sizeof(backends[0])); b++)
+  {
+    Serial.printf("===== storage [%s] =====\r\n\n", backends[b].name);
+    sysLog.setStorage(backends[b].storage);
+    for (uint8_t d = 0; d < (sizeof(depths) / sizeof(depths[0])); d++)
+    {
+      for (uint8_t w = 0; w < (sizeof(lineWidths) / sizeof(lineWidths[0])); w++)
+      {
+        sysLog.removeSysLog();
+        if (!makeRoom(b, depths[d], lineWidths[w])) continue;
+#if defined(ESP32)
+        if (backends[b].storage == NULL) { flashEmulator->resetCounters(); }
+#endif
+        benchmark(depths[d], lineWidths[w]);
+#if defined(ESP32)
+        if (backends[b].storage == NULL)
+        {
+          Serial.printf("%-14s depth[%5d] width[%3d] %d sector erases, %d bytes programmed\r\n\n"
+                                    , "flash wear", depths[d], lineWidths[w]
+                                    , flashEmulator->erases(), flashEmulator->programmedBytes());
+        }
+#endif
+      }
+    }
+    if (makeRoom(b, _WEARDEPTH, _WEARWIDTH)) { wearCompare(b); }
+    sysLog.removeSysLog();
+  }
+  sysLog.setStorage(NULL);
+#if defined(ESP32)
+  delete flashStorage;
+  delete flashEmulator;
+  flashStorage  = NULL;
+  flashEmulator = NULL;
+#endif
+
+  Serial.println("\nBenchmark done .. \n");
+
+} // setup()
+
+
+//-------------------------------------------------------------------------
+void loop()
+{
+  delay(1000);
+
+} // loop()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,199 @@
+/*
+**  Program   : Compression_SysLogger
+**
+**  Writes a few kinds of log lines with setCompression() off, with the
+**  built-in dictionary and with a dictionary made of this sketch's own
+**  format strings. Prints the bytes stored per line, the lines that fit
+**  in the same packed segments and the write and read time per line.
+*/
+#define _FW_VERSION "v2.0.1 (20-12-2022)"
+/*
+**  Copyright (c) 2019 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+#define _FSYS LittleFS
+
+#define _LINES          4000    // lines written per run
+#define _DEPTH           500    // lines of lineWidth that fit in the segments
+#define _RAMDEPTH        100    // lines in the RAM ring for the timing (17KB heap)
+#define _LINEWIDTH       150
+
+ESPSL sysLog;                   // Create instance of the ESPSL object
+
+ESPSL_RamStorage  ramStorage(_RAMDEPTH * (_LINEWIDTH + sizeof(ESPSL_recHeader)) + 1024);
+
+enum { _HEADER, _COUNTER, _SENSOR, _RANDOM };
+
+const char *workloads[] = { "writeToSysLog", "writef counter", "sensor text", "random text" };
+const char *modes[]     = { "off", "built-in", "own dict" };
+const char *funcs[]     = { "setup", "loop", "readSensors", "handleMQTT", "connectWiFi", "updateDisplay" };
+
+//-- the text this sketch logs: its format strings and the function names
+const char *ownDictionary = "[setup       ( [loop        ( [readSensors ( [handleMQTT  ( "
+                            "[connectWiFi ( [updateDisplay( FS File: /sysLog.dat, size: "
+                            "-----[ ]------[ ]----------------------------- "
+                            " temperature  C humidity  % pressure  hPa";
+
+//-------------------------------------------------------------------------
+//-- the same lines for every mode (randomSeed() before the first one)
+void makeLine(char *line, int kind, uint32_t n)
+{
+  int len, i;
+
+  switch(kind)
+  {
+    case _HEADER:   snprintf(line, _LINEWIDTH, "(%4d)[%02d:%02d:%02d][%-12.12s(%4d)] FS File: %s, size: %d"
+                                             , (int)(n % 10000), (int)((n / 3600) % 24), (int)((n / 60) % 60), (int)(n % 60)
+                                             , funcs[n % 6], (int)(100 + random(900)), "/sysLog.dat", (int)random(5000));
+                    break;
+    case _COUNTER:  snprintf(line, _LINEWIDTH, "-----[ %07d ]------[ %04d ]-----------------------------"
+                                             , (int)n, (int)(n % 1000));
+                    break;
+    case _SENSOR:   snprintf(line, _LINEWIDTH, "[%-12.12s] temperature %d.%d C humidity %d %% pressure %d hPa"
+                                             , funcs[n % 6], (int)(15 + random(10)), (int)random(10)
+                                             , (int)(40 + random(30)), (int)(990 + random(40)));
+                    break;
+    default:        len = 20 + random(100);
+                    for (i = 0; i < len; i++) { line[i] = ' ' + random(95); }
+                    line[len] = 0;
+  }
+
+} // makeLine()
+
+//-------------------------------------------------------------------------
+bool countLine(uint32_t lineID, uint32_t timeStamp, const char *line, void *ctx)
+{
+  (*(uint32_t*)ctx)++;
+  return true;
+
+} // countLine()
+
+//-------------------------------------------------------------------------
+void compress(int kind, int mode)
+{
+  char        line[_LINEWIDTH +1];
+  ESPSL_stats stats;
+  uint32_t    n, textBytes = 0, held = 0, reads = 0, writeMicros, readMicros;
+
+  if      (mode == 1) sysLog.setCompression(true);
+  else if (mode == 2) sysLog.setCompression(true, ownDictionary);
+  else                sysLog.setCompression(false);
+
+  //-- bytes stored: packed segments only take the record header and the (compressed) text
+  sysLog.setStorage(NULL);
+  sysLog.setSegments(4096, true);
+  sysLog.removeSysLog();
+  sysLog.begin(_DEPTH, _LINEWIDTH);
+  sysLog.resetStats();
+  randomSeed(kind +1);
+  for (n = 1; n <= _LINES; n++)
+  {
+    makeLine(line, kind, n);
+    textBytes += strlen(line);
+    sysLog.write(line);
+  }
+  sysLog.getStats(&stats);
+  sysLog.readLines(0, 0, countLine, &held);
+  sysLog.removeSysLog();
+  sysLog.setSegments(0);
+
+  //-- time per line, in RAM so it is mostly formatting and (de)compressing
+  sysLog.setStorage(&ramStorage);
+  sysLog.removeSysLog();
+  if (!sysLog.begin(_RAMDEPTH, _LINEWIDTH))
+  {
+    Serial.printf("compress(): no RAM for the timing run .. skipped!\r\n");
+    sysLog.setStorage(NULL);
+    return;
+  }
+  randomSeed(kind +1);
+  writeMicros = 0;
+  for (n = 1; n <= _LINES; n++)
+  {
+    makeLine(line, kind, n);
+    uint32_t startMicros = micros();
+    sysLog.write(line);
+    writeMicros += (micros() - startMicros);
+  }
+  readMicros = micros();
+  sysLog.startReading();
+  while (sysLog.readNextLine(line, sizeof(line))) { reads++; }
+  readMicros = (micros() - readMicros);
+  sysLog.removeSysLog();
+  sysLog.setStorage(NULL);
+
+  Serial.printf("%-15s %-9s text[%5.1f] stored[%5.1f] ratio[%4.2f] held[%5d] write[%6lu ns] read[%6lu ns]\r\n"
+                          , workloads[kind], modes[mode]
+                          , ((float)textBytes / _LINES)
+                          , ((float)stats.bytesWritten / _LINES)
+                          , ((float)(textBytes + (_LINES * sizeof(ESPSL_recHeader))) / stats.bytesWritten)
+                          , held
+                          , (unsigned long)(((uint64_t)writeMicros * 1000) / _LINES)
+                          , (unsigned long)(((uint64_t)readMicros  * 1000) / (reads ? reads : 1)));
+  yield();
+
+} // compress()
+
+//-------------------------------------------------------------------------
+void setup()
+{
+  Serial.begin(115200);
+  Serial.printf("\r\nCompression ESP System Logger %s\r\n\n", _FW_VERSION);
+  Serial.printf("%d lines per run, lineWidth %d, packed segments of %d full lines\r\n", _LINES, _LINEWIDTH, _DEPTH);
+  Serial.printf("text: chars per line, stored: bytes per line (header + text), ratio: text / stored\r\n");
+  Serial.printf("held: lines kept in the segments, write/read: time per line (RAM storage, %d lines)\r\n\n", _RAMDEPTH);
+
+#if defined(ESP8266)
+  _FSYS.begin();
+#else
+  _FSYS.begin(true);
+#endif
+  sysLog.setDebugLvl(0);
+
+  for (int kind = _HEADER; kind <= _RANDOM; kind++)
+  {
+    for (int mode = 0; mode < 3; mode++)
+    {
+      compress(kind, mode);
+    }
+    Serial.println();
+  }
+  sysLog.setCompression(false);
+
+  Serial.println("\nCompression done .. \n");
+
+} // setup()
+
+
+//-------------------------------------------------------------------------
+void loop()
+{
+  delay(1000);
+
+} // loop()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -127,7 +127,7 @@ void testReadnext()
 //-------------------------------------------------------------------------
 void dumpSysLog() 
 {
-  int seekVal = 0, len = 0;
+  int seekVal = 0;
   char cIn;
   
   File sl = LittleFS.open("/sysLog.dat", "r");
@@ -136,16 +136,16 @@ void dumpSysLog()
   while(sl.available())
   {
     cIn = (char)sl.read();
-    len++;
     seekVal++;
-    if (cIn == '\n') 
+    //-- the sysLog file is binary, show non printable chars as '.'
+    if ((cIn < ' ') || (cIn > '~')) cIn = '.';
+    Serial.print(cIn);
+    if ((seekVal % 64) == 0) 
     {
-      Serial.printf("] (len [%d])\r\n", len);
-      len = 0;
-      Serial.printf("%4d [", seekVal);
+      Serial.printf("]\r\n%4d [", seekVal);
     }
-    else  Serial.print(cIn);
   }
+  Serial.println("]");
   sl.close();
   Serial.println("\r\n========================================\r\n");
 
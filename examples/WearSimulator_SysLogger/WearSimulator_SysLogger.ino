@@ -0,0 +1,338 @@
+/*
+**  Program   : WearSimulator_SysLogger
+**
+**  Replays log workloads through ESPSL on a model of LittleFS and on
+**  an emulated raw flash (ESPSL_FlashStorage) and prints the flash wear:
+**  bytes programmed, sectors erased and how the erases are spread over
+**  the blocks. Everything is in RAM, the real flash is not touched.
+*/
+#define _FW_VERSION "v2.0.1 (20-12-2022)"
+/*
+**  Copyright (c) 2019 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+#include "ESPSL_Flash.h"
+#include <new>
+
+#define _BLOCKSIZE      4096    // flash sector and LittleFS block
+#define _FSBLOCKS        256    // blocks in the modelled LittleFS partition (1MB)
+#define _PROGSIZE        256    // a LittleFS metadata commit is padded to this
+#define _ENDURANCE    100000    // erase cycles of a NOR flash sector
+#define _LINES          5000    // lines replayed per workload
+#define _HISTBINS          8    // erase histogram: bins between 0 and the most erases
+#define _HISTBAR          40    // erase histogram: chars of the longest bar
+
+ESPSL sysLog;                   // Create instance of the ESPSL object
+
+enum { _EVERYLINE, _NOFLUSH, _BATCHED };
+
+struct workload {
+  const char  *name;
+  uint16_t     depth;
+  uint16_t     lineWidth;
+  uint8_t      minLen;          // every line gets minLen .. maxLen chars
+  uint8_t      maxLen;
+  uint8_t      policy;          // _EVERYLINE (write() as is), _NOFLUSH or _BATCHED
+  uint16_t     batch;           // _BATCHED: lines per setBuffered() batch
+  uint16_t     linesPerHour;    // to project the wear to years
+} workloads[] = {
+  { "every line",  500,  80, 20,  70, _EVERYLINE,  0, 60 },
+  { "no flush",    500,  80, 20,  70, _NOFLUSH,    0, 60 },
+  { "batch 10",    500,  80, 20,  70, _BATCHED,   10, 60 },
+  { "batch 50",    500,  80, 20,  70, _BATCHED,   50, 60 },
+  { "every line",  100,  80, 20,  70, _EVERYLINE,  0, 60 },
+  { "every line", 2000,  80, 20,  70, _EVERYLINE,  0, 60 },
+  { "every line",  500, 150, 20, 140, _EVERYLINE,  0, 60 },
+};
+
+//-------------------------------------------------------------------------
+//-- a (rough) model of what LittleFS does on the flash for the writes it gets:
+//-- - a file is a list of blocks that point back to the blocks before them,
+//--   so a write that is not at the end of the file goes to a copy of its
+//--   block and every block after it is copied as well (copy-on-write)
+//-- - the copies are made when the file is flushed or when a write is not
+//--   where the previous one ended, into free blocks taken round-robin
+//-- - every flush commits to a metadata block, padded to _PROGSIZE, a full
+//--   metadata block is erased (LittleFS moves the metadata blocks around
+//--   every block_cycles erases, so they are spread round-robin too)
+//-- The file data itself is kept in an ESPSL_RamStorage.
+class LfsModel : public ESPSL_Storage
+{
+  public:
+    LfsModel(uint32_t maxBytes) : _data(maxBytes) { resetCounters(); }
+
+    boolean   exists(const char *fileName)                { return _data.exists(fileName); }
+    boolean   remove(const char *fileName)                { return _data.remove(fileName); }
+    boolean   rename(const char *fromName, const char *toName) { return _data.rename(fromName, toName); }
+    boolean   open(uint8_t fd, const char *fileName, boolean create)
+    {
+      _dirty[fd] = false;
+      return _data.open(fd, fileName, create);
+    }
+    void      close(uint8_t fd)                           { sync(fd); _data.close(fd); }
+    boolean   isOpen(uint8_t fd)                          { return _data.isOpen(fd); }
+    int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len)
+    {
+      return _data.readAt(fd, offset, data, len);
+    }
+    size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len)
+    {
+      if (_dirty[fd] && (offset != _end[fd])) { copyBlocks(fd); }
+      if (!_dirty[fd])
+      {
+        _dirty[fd] = true;
+        _from[fd]  = offset;
+      }
+      _end[fd] = offset + len;
+      return _data.writeAt(fd, offset, data, len);
+    }
+    void      flush(uint8_t fd)                           { sync(fd); _data.flush(fd); }
+    int32_t   size(uint8_t fd)                            { return _data.size(fd); }
+    boolean   truncate(uint8_t fd, uint32_t newSize)      { sync(fd); return _data.truncate(fd, newSize); }
+
+    void      resetCounters()
+    {
+      programmed = 0;
+      erases     = 0;
+      _commits   = 0;
+      memset(blockErases, 0, sizeof(blockErases));
+    }
+
+    uint32_t  programmed;
+    uint32_t  erases;
+    uint32_t  blockErases[_FSBLOCKS];
+
+  private:
+    ESPSL_RamStorage  _data;
+    boolean           _dirty[ESPSL_MAXFILES] = { false, false };
+    uint32_t          _from[ESPSL_MAXFILES];
+    uint32_t          _end[ESPSL_MAXFILES];
+    uint32_t          _commits;
+    uint16_t          _nextBlock = 0;
+
+    void      eraseBlock()
+    {
+      blockErases[_nextBlock]++;
+      erases++;
+      _nextBlock = ((_nextBlock +1) % _FSBLOCKS);
+    }
+
+    //-- copy the block of the first write and every block after it
+    void      copyBlocks(uint8_t fd)
+    {
+      uint32_t fileSize = _data.size(fd);
+
+      for (uint32_t b = (_from[fd] / _BLOCKSIZE); (b * _BLOCKSIZE) < fileSize; b++)
+      {
+        eraseBlock();
+        programmed += (((fileSize - (b * _BLOCKSIZE)) < _BLOCKSIZE) ? (fileSize - (b * _BLOCKSIZE)) : _BLOCKSIZE);
+      }
+      _dirty[fd] = false;
+    }
+
+    void      sync(uint8_t fd)
+    {
+      if (!_dirty[fd]) return;
+      copyBlocks(fd);
+      programmed += _PROGSIZE;
+      if (++_commits >= (_BLOCKSIZE / _PROGSIZE))
+      {
+        _commits = 0;
+        eraseBlock();
+      }
+    }
+};
+
+//-------------------------------------------------------------------------
+//-- begin() on an empty file with the flush policy of the workload
+boolean startLog(ESPSL_Storage *storage, workload *w)
+{
+  sysLog.setStorage(storage);
+  sysLog.removeSysLog();
+  if (!sysLog.begin(w->depth, w->lineWidth))
+  {
+    Serial.printf("startLog(): begin(%d, %d) failed (out of memory?) .. skipped!\r\n", w->depth, w->lineWidth);
+    sysLog.setStorage(NULL);
+    return false;
+  }
+  sysLog.setFlushEveryLine(w->policy != _NOFLUSH);
+  sysLog.setBuffered((w->policy == _BATCHED ? w->batch : 0), 0, 0);
+  return true;
+
+} // startLog()
+
+//-------------------------------------------------------------------------
+//-- write _LINES lines, returns the number of text bytes written
+uint32_t replay(workload *w)
+{
+  char      lLine[200];
+  uint32_t  textBytes = 0;
+  uint8_t   len;
+
+  for (uint32_t l = 0; l < _LINES; l++)
+  {
+    len = random(w->minLen, (w->maxLen +1));
+    snprintf(lLine, sizeof(lLine), "[%05lu] ", (unsigned long)l);
+    while (strlen(lLine) < len) { strlcat(lLine, "-=#=-", len +1); }
+    sysLog.write(lLine);
+    textBytes += strlen(lLine);
+    if ((l % 100) == 0) yield();
+  }
+  sysLog.setBuffered(0, 0, 0);   //-- commit() the last batch
+  sysLog.setFlushEveryLine(true);
+  return textBytes;
+
+} // replay()
+
+//-------------------------------------------------------------------------
+//-- how many blocks were erased how often, _HISTBINS bins from minErases to maxErases
+void printHistogram(uint32_t *perBlock, uint16_t blocks, uint32_t minErases, uint32_t maxErases)
+{
+  uint16_t  inBin[_HISTBINS];
+  uint16_t  mostInBin = 0;
+  uint32_t  binWidth  = (((maxErases - minErases) / _HISTBINS) +1);
+  uint8_t   bins      = (((maxErases - minErases) / binWidth) +1);
+  char      bar[_HISTBAR +1];
+  uint8_t   barLen;
+
+  memset(inBin, 0, sizeof(inBin));
+  for (uint16_t b = 0; b < blocks; b++) { inBin[(perBlock[b] - minErases) / binWidth]++; }
+  for (uint8_t i = 0; i < bins; i++)    { if (inBin[i] > mostInBin) mostInBin = inBin[i]; }
+  for (uint8_t i = 0; i < bins; i++)
+  {
+    barLen = (uint8_t)(((uint32_t)inBin[i] * _HISTBAR + mostInBin -1) / mostInBin);
+    memset(bar, '#', barLen);
+    bar[barLen] = 0;
+    Serial.printf("%19s erases[%6lu..%6lu] blocks[%4d] %s\r\n", ""
+                              , (unsigned long)(minErases + (i * binWidth))
+                              , (unsigned long)(minErases + ((i +1) * binWidth) -1), inBin[i], bar);
+  }
+
+} // printHistogram()
+
+//-------------------------------------------------------------------------
+void printWear(const char *backend, workload *w, uint32_t textBytes, uint32_t programmed
+                                  , uint32_t erases, uint32_t *perBlock, uint16_t blocks)
+{
+  uint32_t  minErases = 0xFFFFFFFF, maxErases = 0;
+  double    linesPerYear = ((double)w->linesPerHour * 24 * 365);
+
+  for (uint16_t b = 0; b < blocks; b++)
+  {
+    if (perBlock[b] < minErases) minErases = perBlock[b];
+    if (perBlock[b] > maxErases) maxErases = perBlock[b];
+  }
+  Serial.printf("%-8s %-10s depth[%5d] width[%3d] text[%7lu] programmed[%8lu] x%5.1f erases[%6lu] %5.1f/kB  block[%4lu/%6.1f/%4lu]"
+                                    , backend, w->name, w->depth, w->lineWidth
+                                    , (unsigned long)textBytes, (unsigned long)programmed
+                                    , ((double)programmed / textBytes)
+                                    , (unsigned long)erases, ((double)erases * 1024 / textBytes)
+                                    , (unsigned long)minErases, ((double)erases / blocks), (unsigned long)maxErases);
+  if (maxErases > 0)
+        Serial.printf("  %8.1f years\r\n", (_ENDURANCE / (maxErases * linesPerYear / _LINES)));
+  else  Serial.printf("         - years\r\n");
+  printHistogram(perBlock, blocks, minErases, maxErases);
+
+} // printWear()
+
+//-------------------------------------------------------------------------
+void simulate(workload *w)
+{
+  uint32_t  ringBytes = ((uint32_t)w->depth * (w->lineWidth + sizeof(ESPSL_recHeader)));
+  uint32_t  sectors   = (2 + ((ringBytes + _BLOCKSIZE -1) / _BLOCKSIZE) +1);
+  uint32_t  textBytes;
+
+  //-- LittleFS (model)
+  LfsModel *lfs = new (std::nothrow) LfsModel(ringBytes + _BLOCKSIZE);
+  if (lfs == NULL)
+  {
+    Serial.printf("simulate(): no memory for the LittleFS model .. skipped!\r\n");
+  }
+  else if (startLog(lfs, w))
+  {
+    lfs->resetCounters();
+    textBytes = replay(w);
+    sysLog.removeSysLog();
+    sysLog.setStorage(NULL);
+    printWear("LittleFS", w, textBytes, lfs->programmed, lfs->erases, lfs->blockErases, _FSBLOCKS);
+  }
+  delete lfs;
+
+  //-- raw flash, journal + ring + the sector erased ahead
+  ESPSL_FlashEmulator *flash        = new (std::nothrow) ESPSL_FlashEmulator(sectors);
+  ESPSL_FlashStorage  *flashStorage = (flash ? new (std::nothrow) ESPSL_FlashStorage(*flash) : NULL);
+  uint32_t            *perSector    = (uint32_t*)malloc(sectors * sizeof(uint32_t));
+  if ((flash == NULL) || (flash->numSectors() != sectors) || (flashStorage == NULL) || (perSector == NULL))
+  {
+    Serial.printf("simulate(): no memory for [%lu] emulated sectors .. skipped!\r\n", (unsigned long)sectors);
+  }
+  else if (startLog(flashStorage, w))
+  {
+    flash->resetCounters();
+    textBytes = replay(w);
+    for (uint32_t s = 0; s < sectors; s++) { perSector[s] = flash->erases(s); }
+    printWear("Flash", w, textBytes, flash->programmedBytes(), flash->erases(), perSector, sectors);
+    sysLog.removeSysLog();
+    sysLog.setStorage(NULL);
+  }
+  free(perSector);
+  delete flashStorage;
+  delete flash;
+
+} // simulate()
+
+//-------------------------------------------------------------------------
+void setup()
+{
+  Serial.begin(115200);
+  Serial.printf("\r\nWear Simulator ESP System Logger %s\r\n\n", _FW_VERSION);
+  Serial.printf("%d lines per workload, programmed: flash bytes programmed (x: per byte of text)\r\n", _LINES);
+  Serial.printf("erases: sectors erased (per kB of text), block[min/avg/max]: erases per sector\r\n");
+  Serial.printf("years: until the most erased sector reaches %d erases\r\n", _ENDURANCE);
+  Serial.printf("below every line: how many blocks were erased how often\r\n\n");
+
+  sysLog.setDebugLvl(0);
+  randomSeed(1);
+
+  for (uint8_t w = 0; w < (sizeof(workloads) / sizeof(workloads[0])); w++)
+  {
+    simulate(&workloads[w]);
+  }
+
+  Serial.println("\nWear Simulator done .. \n");
+
+} // setup()
+
+
+//-------------------------------------------------------------------------
+void loop()
+{
+  delay(1000);
+
+} // loop()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
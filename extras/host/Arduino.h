@@ -0,0 +1,185 @@
+/*
+**  Program   : Arduino.h   (extras/host)
+**
+**  Just enough of the Arduino core to build the ESPSL library and its
+**  examples on a Linux PC (see extras/host/Makefile)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_HOST_ARDUINO_H
+#define _ESPSL_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <string>
+#include <chrono>
+
+#define ESPSL_HOST_FS   "host_fs"     // the directory that is LittleFS on the PC
+
+typedef bool boolean;
+
+//-- host only: malloc()/calloc()/realloc() calls and bytes in use (host.cpp)
+uint32_t  hostAllocs();
+uint32_t  hostHeapUsed();
+
+inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+
+  if (size > 0)
+  {
+    size_t n = (len < (size -1) ? len : (size -1));
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+
+inline size_t strlcat(char *dst, const char *src, size_t size)
+{
+  size_t len = strnlen(dst, size);
+
+  if (len == size) return (size + strlen(src));
+  return (len + strlcpy(dst + len, src, size - len));
+}
+
+inline void          yield()                          { }
+inline void          delay(unsigned long)             { }
+inline long          random(long howBig)              { return (howBig ? (rand() % howBig) : 0); }
+inline long          random(long howSmall, long howBig) { return (howSmall + random(howBig - howSmall)); }
+inline void          randomSeed(unsigned long seed)   { srand(seed); }
+inline unsigned long millis()
+{
+  using namespace std::chrono;
+  return (unsigned long)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+inline unsigned long micros()
+{
+  using namespace std::chrono;
+  return (unsigned long)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//-------------------------------------------------------------------------
+class String : public std::string {
+
+public:
+  String() { }
+  String(const char *s)        : std::string(s) { }
+  String(const std::string &s) : std::string(s) { }
+
+  String  operator+(const String &s) const                   { return String(std::string(*this) + std::string(s)); }
+  friend String operator+(const char *a, const String &b)    { return String(std::string(a) + std::string(b)); }
+  bool    operator==(const char *s) const                    { return (std::string(*this) == s); }
+
+};
+
+//-------------------------------------------------------------------------
+class Print {
+
+public:
+  virtual ~Print() { }
+
+  virtual size_t  write(uint8_t c) = 0;
+  virtual size_t  write(const uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--) { n += write(*buffer++); }
+    return n;
+  }
+  size_t          write(const char *s)          { return write((const uint8_t*)s, strlen(s)); }
+  size_t          print(const char *s)          { return write((const uint8_t*)s, strlen(s)); }
+  size_t          print(int value)              { char buff[16]; snprintf(buff, sizeof(buff), "%d", value); return print(buff); }
+  size_t          println(const char *s)        { return (print(s) + print("\r\n")); }
+  size_t          println()                     { return print("\r\n"); }
+  size_t          printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    char    buff[512];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(buff, sizeof(buff), fmt, args);
+    va_end(args);
+    return print(buff);
+  }
+  virtual int     availableForWrite()           { return 0; }     // as the core: not known
+  virtual void    flush()                       { }
+
+};
+
+//-------------------------------------------------------------------------
+class Stream : public Print {
+
+public:
+  virtual int     available() = 0;
+  virtual int     read() = 0;
+  virtual int     peek()                        { return -1; }
+
+  size_t          readBytes(uint8_t *buffer, size_t length)
+  {
+    size_t n = 0;
+    for (int c; (n < length) && ((c = read()) >= 0); ) { buffer[n++] = (uint8_t)c; }
+    return n;
+  }
+  size_t          readBytes(char *buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+
+};
+
+//-------------------------------------------------------------------------
+//-- Serial is stdout
+class HardwareSerial : public Stream {
+
+public:
+  void    begin(unsigned long)                  { }
+  size_t  write(uint8_t c) override             { return (fputc(c, stdout) == EOF ? 0 : 1); }
+  size_t  write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+  int     available() override                  { return 0; }
+  int     read() override                       { return -1; }
+  int     availableForWrite() override          { return 128; }   // the UART FIFO
+  void    flush() override                      { fflush(stdout); }
+
+};
+extern HardwareSerial Serial;
+
+//-------------------------------------------------------------------------
+//-- the heap of an ESP32 with 300kB free at boot
+class EspClass {
+
+public:
+  String    getSketchMD5();                       // of this program (host.cpp)
+  uint32_t  getFreeHeap()                       { return (300 * 1024) - hostHeapUsed(); }
+  uint32_t  getCycleCount()                     { return (uint32_t)(micros() * 240); }
+
+};
+extern EspClass ESP;
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,172 @@
+/*
+**  Program   : FS.h   (extras/host)
+**
+**  fs::FS and fs::File on top of stdio, all files are in the directory
+**  ESPSL_HOST_FS. File::seek() calls are counted (hostSeeks())
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_HOST_FS_H
+#define _ESPSL_HOST_FS_H
+
+#include "Arduino.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <memory>
+#include <atomic>
+
+//-- host only: File::seek() calls (host.cpp)
+uint32_t  hostSeeks();
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace fs {
+
+extern std::atomic<uint32_t> g_seeks;
+
+std::string hostPath(const char *path);
+
+//-------------------------------------------------------------------------
+class File : public Stream {
+
+public:
+  File() { }
+  File(FILE *file, const char *name) : _file(file, fclose), _name(name) { }
+  File(DIR *dir, const char *path)   : _dir(dir, closedir), _name(path) { }
+
+  operator bool() const               { return (_file || _dir); }
+
+  size_t      write(uint8_t c) override { return write(&c, 1); }
+  size_t      write(const uint8_t *buffer, size_t size) override
+  {
+    return (turn(true) ? fwrite(buffer, 1, size, _file.get()) : 0);
+  }
+  int         available() override    { return (_file ? (int)(size() - position()) : 0); }
+  int         read() override         { return (turn(false) ? fgetc(_file.get()) : -1); }
+  size_t      read(uint8_t *buffer, size_t size)
+  {
+    return (turn(false) ? fread(buffer, 1, size, _file.get()) : 0);
+  }
+  bool        seek(uint32_t pos, SeekMode mode = SeekSet)
+  {
+    if (!_file) return false;
+    g_seeks++;
+    _writing = false;
+    return (fseek(_file.get(), pos, mode) == 0);
+  }
+  size_t      position() const        { return (_file ? (size_t)ftell(_file.get()) : 0); }
+  size_t      size() const
+  {
+    struct stat st;
+    if (!_file) return 0;
+    fflush(_file.get());
+    return (fstat(fileno(_file.get()), &st) == 0 ? (size_t)st.st_size : 0);
+  }
+  bool        truncate(uint32_t size)
+  {
+    if (!_file) return false;
+    fflush(_file.get());
+    return (ftruncate(fileno(_file.get()), size) == 0);
+  }
+  void        flush() override        { if (_file) fflush(_file.get()); }
+  void        close()                 { _file.reset(); _dir.reset(); }
+  const char *name() const            { return _name.c_str(); }
+  bool        isDirectory() const     { return (bool)_dir; }
+  File        openNextFile()
+  {
+    struct dirent *entry;
+
+    while (_dir && ((entry = readdir(_dir.get())) != NULL))
+    {
+      if (entry->d_name[0] == '.') continue;
+      std::string path = _name + (_name == "/" ? "" : "/") + entry->d_name;
+      return File(fopen(hostPath(path.c_str()).c_str(), "rb"), entry->d_name);
+    }
+    return File();
+  }
+
+private:
+  std::shared_ptr<FILE> _file;
+  std::shared_ptr<DIR>  _dir;
+  std::string           _name;
+  bool                  _writing = false;
+
+  //-- stdio needs a seek between a write and a read (not counted, the
+  //-- file position does not change)
+  bool        turn(bool writing)
+  {
+    if (!_file) return false;
+    if (writing != _writing) { fseek(_file.get(), 0, SEEK_CUR); _writing = writing; }
+    return true;
+  }
+
+};
+
+//-------------------------------------------------------------------------
+class FS {
+
+public:
+  bool    begin(bool formatOnFail = false)      { (void)formatOnFail; mkdir(ESPSL_HOST_FS, 0755); return true; }
+  File    open(const char *path, const char *mode = "r")
+  {
+    std::string m(mode);
+
+    if (strcmp(path, "/") == 0) return File(opendir(ESPSL_HOST_FS), "/");
+    if      (m == "r")  m = "rb";
+    else if (m == "r+") m = "r+b";
+    else if (m == "w")  m = "wb";
+    else if (m == "w+") m = "w+b";
+    else if (m == "a")  m = "ab";
+    FILE *file = fopen(hostPath(path).c_str(), m.c_str());
+    if (file == NULL) return File();
+    const char *name = strrchr(path, '/');
+    return File(file, (name ? name +1 : path));
+  }
+  File    open(const String &path, const char *mode = "r")  { return open(path.c_str(), mode); }
+  bool    exists(const char *path)              { struct stat st; return (stat(hostPath(path).c_str(), &st) == 0); }
+  bool    exists(const String &path)            { return exists(path.c_str()); }
+  bool    remove(const char *path)              { return (unlink(hostPath(path).c_str()) == 0); }
+  bool    remove(const String &path)            { return remove(path.c_str()); }
+  bool    rename(const char *from, const char *to)
+  {
+    return (::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0);
+  }
+  bool    rename(const String &from, const String &to)  { return rename(from.c_str(), to.c_str()); }
+  size_t  totalBytes()                          { return (4 * 1024 * 1024); }
+  size_t  usedBytes()                           { return 0; }
+
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,231 @@
+/*
+**  Program   : checks.cpp   (extras/host)
+**
+**  Checks of what the examples can not show: an export to a Stream that
+**  does not know how much room it has or has less room than a line, a
+**  deferred line with a format pointer that is not in this firmware and
+**  a commit() of the write-behind buffer to a storage that fails.
+**  Exits with 1 if a check fails.
+**
+**    make run-checks       (make SANITIZE=1 run-checks for ASan/UBSan)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+
+#define _DEPTH           100
+#define _LINEWIDTH        60
+
+ESPSL sysLog;
+
+//-------------------------------------------------------------------------
+//-- a Stream that counts the lines it gets and has room for room bytes
+class lineSink : public Stream {
+
+public:
+  lineSink(int room) : _room(room) { }
+
+  size_t  write(uint8_t c) override             { if (c == '\n') lines++; return 1; }
+  int     available() override                  { return 0; }
+  int     read() override                       { return -1; }
+  int     availableForWrite() override          { return _room; }
+
+  uint32_t  lines = 0;
+
+private:
+  int       _room;
+
+};
+
+//-------------------------------------------------------------------------
+uint32_t checkExport(const char *what, int room, uint16_t maxLines, uint32_t expectSteps)
+{
+  lineSink  sink(room);
+  uint32_t  steps = 0;
+
+  sysLog.beginExport(sink);
+  while (!sysLog.exportDone() && (steps < (10 * _DEPTH)))
+  {
+    sysLog.exportStep(maxLines, 0);
+    steps++;
+  }
+  printf("export to %-30s lines[%3u] steps[%3u] %s\r\n", what, sink.lines, steps
+                          , (((sink.lines == _DEPTH) && (steps == expectSteps)) ? "ok" : "FAILED"));
+  return (((sink.lines == _DEPTH) && (steps == expectSteps)) ? 0 : 1);
+
+} // checkExport()
+
+//-------------------------------------------------------------------------
+//-- a deferred line of "another firmware" with the tag of this one: its
+//-- format pointer is replaced by one that is not in the read-only data
+//-- (without its crc, a torn record is not read at all)
+uint32_t checkStaleFormat()
+{
+  static const char *fmt = "deferred line %d";
+  char               line[_LINEWIDTH +1];
+  const char        *stale[] = { (const char*)16, line, (const char*)-64 };
+  uint8_t            data[256];
+  uint32_t           bad = 0;
+  int32_t            fileSize, pos;
+
+  for (const char *other : stale)
+  {
+    sysLog.removeSysLog();
+    sysLog.begin(10, _LINEWIDTH);
+    sysLog.writeDeferred(fmt, 42);
+    sysLog.setStorage(NULL);    //-- closes the sysLog file
+
+    File sysLogFile = LittleFS.open("/sysLog.dat", "r+");
+    fileSize = sysLogFile.read(data, sizeof(data));
+    for (pos = 0; pos <= (fileSize - (int32_t)sizeof(fmt)); pos++)
+    {
+      if (memcmp(&data[pos], &fmt, sizeof(fmt)) == 0) break;
+    }
+    if (pos <= (fileSize - (int32_t)sizeof(fmt)))
+    {
+      //-- after the firmware and format tags, the crc no longer matches
+      ESPSL_recHeader *recHdr = (ESPSL_recHeader*)&data[pos - 4 - sizeof(ESPSL_recHeader)];
+      recHdr->flags &= ~_FLAG_CRC;
+      memcpy(&data[pos], &other, sizeof(other));
+      sysLogFile.seek(0, SeekSet);
+      sysLogFile.write(data, fileSize);
+    }
+    sysLogFile.close();
+
+    sysLog.begin(10, _LINEWIDTH);
+    sysLog.startReading();
+    if (!sysLog.readNextLine(line, sizeof(line)))   line[0] = 0;
+    if (   (pos > (fileSize - (int32_t)sizeof(fmt)))
+        || (strstr(line, "from other firmware") == NULL) ) bad++;
+    printf("deferred line, format at %-18p [%s] %s\r\n", (const void*)other, line, (bad ? "FAILED" : "ok"));
+  }
+  sysLog.removeSysLog();
+  return bad;
+
+} // checkStaleFormat()
+
+//-------------------------------------------------------------------------
+//-- a RAM storage that fails every write while failing is set
+class flakyStorage : public ESPSL_RamStorage {
+
+public:
+  flakyStorage() : ESPSL_RamStorage(64 * 1024) { }
+
+  size_t  writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len) override
+  {
+    return (failing ? 0 : ESPSL_RamStorage::writeAt(fd, offset, data, len));
+  }
+
+  boolean   failing = false;
+
+};
+
+//-------------------------------------------------------------------------
+//-- the lines in the sysLog file (after begin() read it again) are 1 .. last,
+//-- without goneFrom .. goneTo
+uint32_t checkLines(const char *what, int last, int goneFrom, int goneTo)
+{
+  char      line[_LINEWIDTH +1], expected[_LINEWIDTH +1];
+  int       n = 1, lines = 0;
+  uint32_t  bad = 0;
+
+  sysLog.begin(50, _LINEWIDTH);
+  sysLog.startReading();
+  while (sysLog.readNextLine(line, sizeof(line)))
+  {
+    if (n == goneFrom) { n = (goneTo +1); }
+    snprintf(expected, sizeof(expected), "buffered line %03d", n++);
+    if (strcmp(line, expected) != 0) bad++;
+    lines++;
+  }
+  if (n != (last +1)) bad++;
+  printf("commit() %-31s lines[%3d] %s\r\n", what, lines, (bad ? "FAILED" : "ok"));
+  return bad;
+
+} // checkLines()
+
+//-------------------------------------------------------------------------
+uint32_t checkFailedCommit()
+{
+  flakyStorage  flaky;
+  ESPSL_stats   stats;
+  uint32_t      bad = 0;
+  int           n;
+
+  sysLog.setStorage(&flaky);
+  sysLog.removeSysLog();
+  sysLog.begin(50, _LINEWIDTH);
+  sysLog.setBuffered(10, 0, 0);
+
+  //-- the lines stay pending, the next commit() writes them
+  for (n = 1; n <= 5; n++) { sysLog.writef("buffered line %03d", n); }
+  flaky.failing = true;
+  if (sysLog.commit()) bad++;
+  flaky.failing = false;
+  if (!sysLog.commit()) bad++;
+  bad += checkLines("after a failed commit()", 5, 0, 0);
+
+  //-- a full buffer that can not be written drops its oldest lines
+  sysLog.setBuffered(10, 0, 0);
+  sysLog.resetStats();
+  flaky.failing = true;
+  for (n = 6; n <= 20; n++) { sysLog.writef("buffered line %03d", n); }
+  flaky.failing = false;
+  if (!sysLog.commit()) bad++;
+  sysLog.getStats(&stats);
+  if (stats.droppedLines != 5) bad++;
+  bad += checkLines("with 5 lines dropped", 20, 6, 10);
+
+  sysLog.setBuffered(0, 0, 0);
+  sysLog.removeSysLog();
+  sysLog.setStorage(NULL);
+  return bad;
+
+} // checkFailedCommit()
+
+//-------------------------------------------------------------------------
+int main()
+{
+  uint32_t bad = 0;
+
+  LittleFS.begin();
+  sysLog.removeSysLog();
+  sysLog.begin(_DEPTH, _LINEWIDTH);
+  for (int n = 0; n < _DEPTH; n++) { sysLog.writef("line %03d of the export", n); }
+
+  bad += checkExport("availableForWrite() 0",     0, 10, _DEPTH);
+  bad += checkExport("room for less than a line", 8, 10, _DEPTH);
+  bad += checkExport("room for every line",    4096, 10, (_DEPTH / 10));
+  bad += checkStaleFormat();
+  bad += checkFailedCommit();
+  sysLog.removeSysLog();
+
+  return (bad ? 1 : 0);
+
+} // main()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,61 @@
+/*
+**  Program   : esp_partition.h   (extras/host)
+**
+**  There are no partitions on the PC: esp_partition_find_first() finds
+**  nothing, so an ESPSL_PartitionFlash has no sectors and ESPSL::begin()
+**  on its ESPSL_FlashStorage returns false (use ESPSL_FlashEmulator)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_HOST_ESP_PARTITION_H
+#define _ESPSL_HOST_ESP_PARTITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+#define ESP_OK    0
+#define ESP_FAIL  -1
+
+typedef enum { ESP_PARTITION_TYPE_DATA    = 0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY  = 0xff } esp_partition_subtype_t;
+
+typedef struct {
+  uint32_t  address;
+  uint32_t  size;
+  char      label[17];
+} esp_partition_t;
+
+inline const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char*)
+                                                                      { return NULL; }
+inline esp_err_t esp_partition_read(const esp_partition_t*, size_t, void*, size_t)        { return ESP_FAIL; }
+inline esp_err_t esp_partition_write(const esp_partition_t*, size_t, const void*, size_t) { return ESP_FAIL; }
+inline esp_err_t esp_partition_erase_range(const esp_partition_t*, size_t, size_t)        { return ESP_FAIL; }
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,163 @@
+/*
+**  Program   : find_bench.cpp   (extras/host)
+**
+**  find() against a readNextLine() + strstr() loop over the same lines,
+**  for a pattern that is in about every 10th line, one that is in no line
+**  and the newest line with the pattern (find() backward, maxHits 1).
+**  Time per line (best of _RUNS), seeks and heap calls per search.
+**
+**    make run-find
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+#include <chrono>
+
+#define _LINEWIDTH       100
+#define _RUNS              5
+
+ESPSL             sysLog;
+ESPSL_FSStorage   fsStorage(LittleFS);
+ESPSL_RamStorage  ramStorage(2 * 1024 * 1024);
+
+struct backend {
+  const char    *name;
+  ESPSL_Storage *storage;
+} backends[] = {
+  { "LittleFS", &fsStorage  },
+  { "RAM",      &ramStorage },
+};
+
+const uint16_t  depths[] = { 100, 1000, 10000 };
+
+//-- what one way of searching cost
+struct result {
+  uint64_t  nanos;            // best run
+  uint32_t  seeks;
+  uint32_t  allocs;
+  int32_t   hits;
+};
+
+//-------------------------------------------------------------------------
+uint64_t nanos()
+{
+  using namespace std::chrono;
+  return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+
+} // nanos()
+
+//-------------------------------------------------------------------------
+bool countHit(uint32_t lineID, uint32_t timeStamp, const char *line, void *ctx)
+{
+  (void)lineID; (void)timeStamp; (void)line;
+  (*(int32_t*)ctx)++;
+  return true;
+
+} // countHit()
+
+//-------------------------------------------------------------------------
+//-- search the whole sysLog _RUNS times, way 0: strstr() loop, 1: find()
+//-- forward, 2: find() backward for the newest hit only
+result search(int way, const char *pattern)
+{
+  result    res = { UINT64_MAX, 0, 0, 0 };
+  char      line[_LINEWIDTH +1];
+  uint64_t  start;
+  uint32_t  seeks, allocs;
+
+  for (int run = 0; run < _RUNS; run++)
+  {
+    res.hits = 0;
+    seeks    = hostSeeks();
+    allocs   = hostAllocs();
+    start    = nanos();
+    if (way == 0)
+    {
+      sysLog.startReading();
+      while (sysLog.readNextLine(line, sizeof(line))) { if (strstr(line, pattern)) res.hits++; }
+    }
+    else if (way == 1) { sysLog.find(pattern, countHit, &res.hits); }
+    else               { sysLog.find(pattern, countHit, &res.hits, ESPSL_FIND_BACKWARD, 1); }
+    start = (nanos() - start);
+    if (start < res.nanos) { res.nanos = start; }
+    res.seeks  = (hostSeeks() - seeks);
+    res.allocs = (hostAllocs() - allocs);
+  }
+  return res;
+
+} // search()
+
+//-------------------------------------------------------------------------
+void compare(uint16_t depth, const char *pattern)
+{
+  result  loop     = search(0, pattern);
+  result  forward  = search(1, pattern);
+  result  backward = search(2, pattern);
+
+  printf("  depth[%5d] [%-14s] hits[%5d] strstr() loop %6.0f ns/line seeks[%5u] allocs[%3u]"
+         " | find() %6.0f ns/line seeks[%4u] allocs[%3u] %5.1fx | newest %8.1f us\r\n"
+                  , depth, pattern, forward.hits
+                  , (double)loop.nanos / depth, loop.seeks, loop.allocs
+                  , (double)forward.nanos / depth, forward.seeks, forward.allocs
+                  , (double)loop.nanos / (double)forward.nanos
+                  , (double)backward.nanos / 1000);
+  if (loop.hits != forward.hits)
+  {
+    printf("  strstr() loop found [%d] lines, find() [%d]\r\n", loop.hits, forward.hits);
+  }
+
+} // compare()
+
+//-------------------------------------------------------------------------
+int main()
+{
+  LittleFS.begin();
+  for (backend &b : backends)
+  {
+    printf("===== storage [%s] =====\r\n", b.name);
+    sysLog.setStorage(b.storage);
+    for (uint16_t depth : depths)
+    {
+      sysLog.removeSysLog();
+      sysLog.begin(depth, _LINEWIDTH);
+      for (uint32_t n = 0; n < depth; n++)
+      {
+        sysLog.writef("(%5u)[loop        (%4u)] FS File: /sysLog.dat, size: %u"
+                                        , n, (100 + ((n * 7) % 900)), ((n % 10) == 3 ? 1234 : 5678));
+      }
+      compare(depth, "size: 1234");
+      compare(depth, "no such text");
+    }
+    sysLog.removeSysLog();
+  }
+  sysLog.setStorage(NULL);
+
+  return 0;
+
+} // main()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
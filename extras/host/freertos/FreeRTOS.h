@@ -0,0 +1,166 @@
+/*
+**  Program   : freertos/FreeRTOS.h   (extras/host)
+**
+**  The FreeRTOS calls ESPSL::startWriter() uses, on std::thread. A task is
+**  a detached thread, a mutex is a std::recursive_mutex and a task
+**  notification is a counter with a condition variable. Ticks are milliseconds.
+**  A task is freed by its vTaskDelete(NULL), a later xTaskNotifyGive() to it
+**  does nothing (FreeRTOS does not allow it, the host checks it)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_HOST_FREERTOS_H
+#define _ESPSL_HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <set>
+
+typedef unsigned  UBaseType_t;
+typedef int       BaseType_t;
+typedef uint32_t  TickType_t;
+
+#define pdPASS              1
+#define pdFAIL              0
+#define pdTRUE              1
+#define pdFALSE             0
+#define portMAX_DELAY       0xFFFFFFFFu
+#define tskNO_AFFINITY      0x7FFFFFFF
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+struct hostTask {
+  std::mutex              lock;
+  std::condition_variable wake;
+  uint32_t                notified = 0;
+};
+typedef hostTask *TaskHandle_t;
+
+struct hostSemaphore {
+  std::recursive_mutex    lock;
+};
+typedef hostSemaphore *SemaphoreHandle_t;
+
+inline thread_local hostTask *hostCurrentTask = NULL;
+
+//-- the tasks that are not deleted, a handle is only used while it is in here.
+//-- Never destroyed, a task can still delete itself while the program exits
+struct hostTaskList {
+  std::mutex              lock;
+  std::set<hostTask*>     tasks;
+};
+inline hostTaskList &hostTasks()
+{
+  static hostTaskList *list = new hostTaskList;
+  return *list;
+}
+
+//-------------------------------------------------------------------------
+inline BaseType_t xTaskCreatePinnedToCore(void (*taskCode)(void*), const char*, uint32_t, void *param
+                                          , UBaseType_t, TaskHandle_t *handle, BaseType_t)
+{
+  hostTask *task = new hostTask;
+
+  {
+    std::lock_guard<std::mutex> guard(hostTasks().lock);
+    hostTasks().tasks.insert(task);
+  }
+  *handle = task;
+  std::thread([=] { hostCurrentTask = task; taskCode(param); }).detach();
+  return pdPASS;
+}
+
+//-- only vTaskDelete(NULL) at the end of the task function is supported
+inline void vTaskDelete(TaskHandle_t)
+{
+  std::lock_guard<std::mutex> guard(hostTasks().lock);
+
+  hostTasks().tasks.erase(hostCurrentTask);
+  delete hostCurrentTask;
+  hostCurrentTask = NULL;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task)
+{
+  std::lock_guard<std::mutex> tasks(hostTasks().lock);
+
+  if (hostTasks().tasks.count(task) == 0) return;
+  std::lock_guard<std::mutex> guard(task->lock);
+  task->notified++;
+  task->wake.notify_one();
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+  hostTask                     *task = hostCurrentTask;
+  std::unique_lock<std::mutex>  guard(task->lock);
+  uint32_t                      notified;
+
+  task->wake.wait_for(guard, std::chrono::milliseconds(ticks), [task] { return (task->notified > 0); });
+  notified = task->notified;
+  task->notified = (clearOnExit ? 0 : (notified ? notified -1 : 0));
+  return notified;
+}
+
+//-------------------------------------------------------------------------
+inline SemaphoreHandle_t xSemaphoreCreateMutex()                { return new hostSemaphore; }
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()       { return new hostSemaphore; }
+inline void              vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
+
+//-- try_lock() in a loop, ThreadSanitizer does not see a try_lock_for()
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+  auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+
+  if (ticks == portMAX_DELAY) { sem->lock.lock(); return pdTRUE; }
+  while (!sem->lock.try_lock())
+  {
+    if (std::chrono::steady_clock::now() >= until) return pdFALSE;
+    std::this_thread::yield();
+  }
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+  sem->lock.unlock();
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) { return xSemaphoreTake(sem, ticks); }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)                   { return xSemaphoreGive(sem); }
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
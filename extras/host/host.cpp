@@ -0,0 +1,138 @@
+/*
+**  Program   : host.cpp   (extras/host)
+**
+**  The globals of the Arduino core (Serial, ESP, LittleFS) and the
+**  counters of the host build. malloc(), calloc(), realloc() and free()
+**  are wrapped by the linker (-Wl,--wrap=..) so every heap call made by
+**  the library and the sketches is counted. ESP.getSketchMD5() is a hash
+**  of the executable, so every build has its own firmwareTag()
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include <malloc.h>
+
+HardwareSerial  Serial;
+EspClass        ESP;
+fs::FS          LittleFS;
+
+namespace fs {
+
+std::atomic<uint32_t> g_seeks{0};
+
+std::string hostPath(const char *path)
+{
+  return (std::string(ESPSL_HOST_FS) + path);
+
+} // hostPath()
+
+} // namespace fs
+
+static std::atomic<uint32_t>  heapCalls{0};
+static std::atomic<int64_t>   heapBytes{0};
+
+//-------------------------------------------------------------------------
+//-- every build gets another "MD5": two FNV-1a hashes of the executable
+String EspClass::getSketchMD5()
+{
+  static char md5[33] = "";
+  uint64_t    hash[2] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL };
+  FILE       *exe;
+  int         c;
+
+  if (md5[0] != 0) return String(md5);
+  if ((exe = fopen("/proc/self/exe", "rb")) != NULL)
+  {
+    while ((c = fgetc(exe)) != EOF)
+    {
+      hash[0] = ((hash[0] ^ (uint8_t)c) * 0x100000001b3ULL);
+      hash[1] = ((hash[1] ^ (uint8_t)c) * 0x100000001b3ULL);
+    }
+    fclose(exe);
+  }
+  snprintf(md5, sizeof(md5), "%016llx%016llx", (unsigned long long)hash[0], (unsigned long long)hash[1]);
+  return String(md5);
+
+} // getSketchMD5()
+
+//-------------------------------------------------------------------------
+uint32_t hostAllocs()   { return heapCalls; }
+uint32_t hostHeapUsed() { return (uint32_t)heapBytes; }
+uint32_t hostSeeks()    { return fs::g_seeks; }
+
+//-------------------------------------------------------------------------
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void  __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+  void *ptr = __real_malloc(size);
+
+  if (ptr != NULL) { heapCalls++; heapBytes += malloc_usable_size(ptr); }
+  return ptr;
+
+} // __wrap_malloc()
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  void *ptr = __real_calloc(count, size);
+
+  if (ptr != NULL) { heapCalls++; heapBytes += malloc_usable_size(ptr); }
+  return ptr;
+
+} // __wrap_calloc()
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  size_t  oldSize = (ptr ? malloc_usable_size(ptr) : 0);
+  void   *newPtr  = __real_realloc(ptr, size);
+
+  if (newPtr != NULL)
+  {
+    heapCalls++;
+    heapBytes += ((int64_t)malloc_usable_size(newPtr) - (int64_t)oldSize);
+  }
+  else if (size == 0) { heapBytes -= oldSize; }
+  return newPtr;
+
+} // __wrap_realloc()
+
+void __wrap_free(void *ptr)
+{
+  if (ptr != NULL) { heapBytes -= malloc_usable_size(ptr); }
+  __real_free(ptr);
+
+} // __wrap_free()
+
+} // extern "C"
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,202 @@
+/*
+**  Program   : stress_async.cpp   (extras/host)
+**
+**  writeAsync() from several std::threads at once, with another thread
+**  reading the counters, for every ring-full policy. Afterwards every line
+**  in the sysLog file must be intact, once, and in the order its thread
+**  queued it, and the counters of getAsyncStats() must add up.
+**
+**    make run-stress       (make SANITIZE=thread run-stress for TSan)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#include "LittleFS_SysLogger.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#define _PRODUCERS         4
+#define _LINES          2500    // per producer
+#define _DEPTH         12000    // holds every line
+#define _LINEWIDTH        60
+
+ESPSL sysLog;
+
+const char *policies[] = { "drop", "block", "overwrite" };
+
+struct checkLines {
+  int32_t   lastSeq[_PRODUCERS];
+  uint32_t  lastLineID;
+  uint32_t  lines;
+  uint32_t  bad;
+};
+
+//-------------------------------------------------------------------------
+//-- the text of line n of producer p (always shorter than _LINEWIDTH)
+void makeLine(char *line, size_t lineLen, int p, int n)
+{
+  char  filler[32];
+  int   len = 10 + ((p * 7 + n) % 20);
+
+  for (int i = 0; i < len; i++) { filler[i] = 'a' + ((p + n + i) % 26); }
+  filler[len] = 0;
+  snprintf(line, lineLen, "P%d #%05d %s", p, n, filler);
+
+} // makeLine()
+
+//-------------------------------------------------------------------------
+bool checkLine(uint32_t lineID, uint32_t timeStamp, const char *line, void *ctx)
+{
+  checkLines *check = (checkLines*)ctx;
+  char        expected[_LINEWIDTH +1];
+  int         p, n;
+
+  (void)timeStamp;
+  check->lines++;
+  if ((check->lastLineID != 0) && (lineID != (check->lastLineID +1)))
+  {
+    printf("lineID [%u] after [%u]\r\n", lineID, check->lastLineID);
+    check->bad++;
+  }
+  check->lastLineID = lineID;
+  if ((sscanf(line, "P%d #%d", &p, &n) != 2) || (p < 0) || (p >= _PRODUCERS))
+  {
+    printf("line [%u] garbled [%s]\r\n", lineID, line);
+    check->bad++;
+    return true;
+  }
+  makeLine(expected, sizeof(expected), p, n);
+  if (strcmp(line, expected) != 0)
+  {
+    printf("line [%u] is [%s] instead of [%s]\r\n", lineID, line, expected);
+    check->bad++;
+  }
+  if (n <= check->lastSeq[p])
+  {
+    printf("line [%u] P%d #%d after #%d\r\n", lineID, p, n, check->lastSeq[p]);
+    check->bad++;
+  }
+  check->lastSeq[p] = n;
+  return true;
+
+} // checkLine()
+
+//-------------------------------------------------------------------------
+uint32_t stress(uint8_t policy, uint16_t ringSize)
+{
+  std::vector<std::thread>  producers;
+  std::atomic<uint32_t>     queued{0};
+  std::atomic<bool>         running{true};
+  ESPSL_asyncStats          asyncStats;
+  ESPSL_stats               stats;
+  checkLines                check;
+  uint32_t                  statReads = 0, torn = 0, bad = 0;
+
+  sysLog.removeSysLog();
+  sysLog.begin(_DEPTH, _LINEWIDTH);
+  sysLog.resetStats();
+  if (!sysLog.startWriter(ringSize, policy))
+  {
+    printf("startWriter() failed\r\n");
+    return 1;
+  }
+
+  //-- the counters while the lines are queued and written (without lock()),
+  //-- a copy made while the writer task updates them does not add up
+  std::thread reader([&] {
+    while (running)
+    {
+      uint32_t inHist = 0;
+      sysLog.getStats(&stats);
+      sysLog.getAsyncStats(&asyncStats);
+      for (int b = 0; b < ESPSL_HISTBINS; b++) { inHist += stats.write.hist[b]; }
+      if (inHist != stats.write.count) { torn++; }
+      statReads++;
+    }
+  });
+
+  for (int p = 0; p < _PRODUCERS; p++)
+  {
+    producers.emplace_back([&queued, p] {
+      char  line[_LINEWIDTH +1];
+      for (int n = 0; n < _LINES; n++)
+      {
+        makeLine(line, sizeof(line), p, n);
+        if (sysLog.writeAsync("%s", line)) { queued++; }
+      }
+    });
+  }
+  for (std::thread &producer : producers) { producer.join(); }
+  running = false;
+  reader.join();
+  sysLog.stopWriter();
+
+  memset(&check, 0, sizeof(check));
+  for (int p = 0; p < _PRODUCERS; p++) { check.lastSeq[p] = -1; }
+  sysLog.readLines(0, 0, checkLine, &check);
+  sysLog.getAsyncStats(&asyncStats);
+  sysLog.getStats(&stats);
+
+  //-- every line is queued or dropped, every queued line is written or overwritten
+  if ((asyncStats.enqueued + asyncStats.dropped) != (_PRODUCERS * _LINES))   { printf("queued + dropped\r\n");  bad++; }
+  if (asyncStats.enqueued != queued)                                        { printf("queued\r\n");            bad++; }
+  if ((asyncStats.written + asyncStats.overwritten) != asyncStats.enqueued) { printf("written\r\n");           bad++; }
+  if (check.lines != asyncStats.written)                                    { printf("lines in file\r\n");     bad++; }
+  if (stats.linesWritten != asyncStats.written)                             { printf("linesWritten\r\n");      bad++; }
+  if ((policy == ESPSL_Q_BLOCK) && (check.lines != (_PRODUCERS * _LINES)))  { printf("lines blocked\r\n");     bad++; }
+  if (torn > 0)                                                             { printf("torn stats\r\n");        bad++; }
+  bad += check.bad;
+
+  printf("%-9s ring[%4d] queued[%5u] dropped[%5u] overwritten[%5u] written[%5u] in file[%5u] enqueue avg[%3u] max[%5u] us, %u stat reads, %s\r\n"
+                          , policies[policy], ringSize, asyncStats.enqueued, asyncStats.dropped
+                          , asyncStats.overwritten, asyncStats.written, check.lines
+                          , asyncStats.avgMicros, asyncStats.maxMicros, statReads
+                          , (bad ? "FAILED" : "ok"));
+  return bad;
+
+} // stress()
+
+//-------------------------------------------------------------------------
+int main()
+{
+  uint32_t bad = 0;
+
+  LittleFS.begin();
+  printf("%d producers of %d lines\r\n", _PRODUCERS, _LINES);
+  for (int run = 0; run < 3; run++)
+  {
+    bad += stress(ESPSL_Q_BLOCK,     16);
+    bad += stress(ESPSL_Q_DROP,      64);
+    bad += stress(ESPSL_Q_OVERWRITE, 64);
+  }
+  sysLog.removeSysLog();
+
+  return (bad ? 1 : 0);
+
+} // main()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+***************************************************************************/
@@ -0,0 +1,536 @@
+/***************************************************************************
+**  Program   : ESPSL_Flash.cpp
+**
+**  Version   : 2.0.1   (20-12-2022)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+****************************************************************************
+*/
+
+#include "ESPSL_Flash.h"
+
+#define _JOURNALSECTORS   2     // sectors 0 and 1 hold the file header journal
+#define _BLANKCHUNK      64     // bytes read at once to check for erased flash
+
+//=====================================================================================
+//-- ESPSL_FlashEmulator: flash image in RAM
+//=====================================================================================
+ESPSL_FlashEmulator::ESPSL_FlashEmulator(uint32_t numSectors, uint32_t sectorSize)
+{
+  _numSectors = numSectors;
+  _sectorSize = sectorSize;
+  _image      = (uint8_t*)malloc(_numSectors * _sectorSize);
+  _erases     = (uint32_t*)calloc(_numSectors, sizeof(uint32_t));
+  if ((_image == NULL) || (_erases == NULL))
+  {
+    free(_image);
+    free(_erases);
+    _image      = NULL;
+    _erases     = NULL;
+    _numSectors = 0;
+    return;
+  }
+  memset(_image, 0xFF, (_numSectors * _sectorSize));    //-- a new chip is erased
+
+} // ESPSL_FlashEmulator()
+
+//-------------------------------------------------------------------------------------
+ESPSL_FlashEmulator::~ESPSL_FlashEmulator()
+{
+  free(_image);
+  free(_erases);
+
+} // ~ESPSL_FlashEmulator()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashEmulator::read(uint32_t addr, uint8_t *data, size_t len)
+{
+  if ((addr + len) > (_numSectors * _sectorSize)) return false;
+  memcpy(data, &_image[addr], len);
+  return true;
+
+} // read()
+
+//-------------------------------------------------------------------------------------
+//-- like a NOR flash chip: the bits end up as (old AND new)
+boolean ESPSL_FlashEmulator::program(uint32_t addr, const uint8_t *data, size_t len)
+{
+  boolean failed = false;
+
+  if (len == 0) return true;
+  if ((addr + len) > (_numSectors * _sectorSize)) return false;
+  for (size_t i = 0; i < len; i++)
+  {
+    if (data[i] & ~_image[addr + i]) { failed = true; }
+    _image[addr + i] &= data[i];
+  }
+  _pages += ((addr + len -1) / ESPSL_FLASHPAGE) - (addr / ESPSL_FLASHPAGE) +1;
+  _bytes += len;
+  if (failed) { _failed++; }
+  return true;
+
+} // program()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashEmulator::eraseSector(uint32_t sector)
+{
+  if (sector >= _numSectors) return false;
+  memset(&_image[sector * _sectorSize], 0xFF, _sectorSize);
+  _erases[sector]++;
+  return true;
+
+} // eraseSector()
+
+//-------------------------------------------------------------------------------------
+uint32_t ESPSL_FlashEmulator::erases()
+{
+  uint32_t total = 0;
+
+  for (uint32_t s = 0; s < _numSectors; s++) { total += _erases[s]; }
+  return total;
+
+} // erases()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_FlashEmulator::resetCounters()
+{
+  if (_erases != NULL) { memset(_erases, 0, (_numSectors * sizeof(uint32_t))); }
+  _pages  = 0;
+  _bytes  = 0;
+  _failed = 0;
+
+} // resetCounters()
+
+
+//=====================================================================================
+//-- ESPSL_PartitionFlash: the real thing
+//=====================================================================================
+#if defined(ESP32)
+ESPSL_PartitionFlash::ESPSL_PartitionFlash(const char *label)
+{
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  _size      = (_partition != NULL ? _partition->size : 0);
+
+} // ESPSL_PartitionFlash()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::read(uint32_t addr, uint8_t *data, size_t len)
+{
+  if ((_partition == NULL) || ((addr + len) > _size)) return false;
+  return (esp_partition_read(_partition, addr, data, len) == ESP_OK);
+
+} // read()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::program(uint32_t addr, const uint8_t *data, size_t len)
+{
+  if ((_partition == NULL) || ((addr + len) > _size)) return false;
+  return (esp_partition_write(_partition, addr, data, len) == ESP_OK);
+
+} // program()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::eraseSector(uint32_t sector)
+{
+  if ((_partition == NULL) || (sector >= numSectors())) return false;
+  return (esp_partition_erase_range(_partition, (sector * 4096), 4096) == ESP_OK);
+
+} // eraseSector()
+
+#else
+ESPSL_PartitionFlash::ESPSL_PartitionFlash(uint32_t startAddr, uint32_t size)
+{
+  _startAddr = (startAddr & ~4095);
+  _size      = (size & ~4095);
+
+} // ESPSL_PartitionFlash()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::read(uint32_t addr, uint8_t *data, size_t len)
+{
+  if ((addr + len) > _size) return false;
+  return ESP.flashRead(_startAddr + addr, data, len);
+
+} // read()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::program(uint32_t addr, const uint8_t *data, size_t len)
+{
+  if ((addr + len) > _size) return false;
+  return ESP.flashWrite(_startAddr + addr, data, len);
+
+} // program()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PartitionFlash::eraseSector(uint32_t sector)
+{
+  if (sector >= numSectors()) return false;
+  return ESP.flashEraseSector((_startAddr / 4096) + sector);
+
+} // eraseSector()
+#endif
+
+
+//=====================================================================================
+//-- ESPSL_FlashStorage: the sysLog file as an append-only log on flash
+//=====================================================================================
+ESPSL_FlashStorage::ESPSL_FlashStorage(ESPSL_Flash &flash, const char *fileName) : _flash(flash)
+{
+  _fileName = fileName;
+  memset(&_fileHdr, 0, sizeof(_fileHdr));
+
+} // ESPSL_FlashStorage()
+
+//-------------------------------------------------------------------------------------
+uint32_t ESPSL_FlashStorage::capacity()
+{
+  if (_flash.numSectors() <= _JOURNALSECTORS) return 0;
+  return ((_flash.numSectors() - _JOURNALSECTORS) * _flash.sectorSize());
+
+} // capacity()
+
+//-------------------------------------------------------------------------------------
+//-- bytes of the slots (from the file header), the sectors after them are not used
+uint32_t ESPSL_FlashStorage::ringBytes()
+{
+  uint32_t bytes;
+
+  if (!_hasHeader) return capacity();
+  bytes = _fileHdr.numLines * (sizeof(ESPSL_recHeader) + _fileHdr.lineWidth);
+  return (bytes < capacity() ? bytes : capacity());
+
+} // ringBytes()
+
+//-------------------------------------------------------------------------------------
+uint32_t ESPSL_FlashStorage::entryCheck(const ESPSL_journalEntry *entry)
+{
+  uint32_t check = (entry->seq ^ 0x4C505345);
+
+  for (uint8_t i = 0; i < sizeof(entry->fileHdr); i++) { check = ((check << 5) + check) + entry->fileHdr[i]; }
+  return check;
+
+} // entryCheck()
+
+//-------------------------------------------------------------------------------------
+//-- find the newest complete file header in the journal
+boolean ESPSL_FlashStorage::loadHeader()
+{
+  ESPSL_journalEntry entry;
+  uint32_t           perSector = (_flash.sectorSize() / sizeof(ESPSL_journalEntry));
+  uint32_t           firstFree[_JOURNALSECTORS];
+  uint32_t           i;
+
+  _hasHeader = false;
+  _seq       = 0;
+  _jSector   = 0;
+  for (uint8_t j = 0; j < _JOURNALSECTORS; j++)
+  {
+    firstFree[j] = perSector;
+    for (i = 0; i < perSector; i++)
+    {
+      if (!_flash.read(((j * _flash.sectorSize()) + (i * sizeof(entry))), (uint8_t*)&entry, sizeof(entry))) break;
+      if (entry.seq == 0xFFFFFFFF)
+      {
+        firstFree[j] = i;
+        break;
+      }
+      if ((entry.check == entryCheck(&entry)) && (!_hasHeader || (entry.seq > _seq)))
+      {
+        memcpy(&_fileHdr, entry.fileHdr, sizeof(_fileHdr));
+        _hasHeader = true;
+        _seq       = entry.seq;
+        _jSector   = j;
+      }
+    }
+  }
+  _jNext = firstFree[_jSector];
+  return _hasHeader;
+
+} // loadHeader()
+
+//-------------------------------------------------------------------------------------
+//-- append the file header to the journal, if the journal sector is full
+//-- continue in the other one (erased first)
+boolean ESPSL_FlashStorage::saveHeader()
+{
+  ESPSL_journalEntry entry;
+  uint32_t           perSector = (_flash.sectorSize() / sizeof(ESPSL_journalEntry));
+
+  memset(&entry, 0xFF, sizeof(entry));
+  entry.seq = ++_seq;
+  memcpy(entry.fileHdr, &_fileHdr, sizeof(_fileHdr));
+  entry.check = entryCheck(&entry);
+
+  if (_jNext >= perSector)
+  {
+    _jSector = ((_jSector +1) % _JOURNALSECTORS);
+    _jNext   = 0;
+    if (!eraseIfUsed(_jSector)) return false;
+  }
+  if (!_flash.program(((_jSector * _flash.sectorSize()) + (_jNext * sizeof(entry))), (const uint8_t*)&entry, sizeof(entry))) return false;
+  _jNext++;
+  return true;
+
+} // saveHeader()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashStorage::isBlank(uint32_t sector)
+{
+  uint8_t  chunk[_BLANKCHUNK];
+  uint32_t addr, i;
+
+  for (addr = (sector * _flash.sectorSize()); addr < ((sector +1) * _flash.sectorSize()); addr += sizeof(chunk))
+  {
+    if (!_flash.read(addr, chunk, sizeof(chunk))) return false;
+    for (i = 0; i < sizeof(chunk); i++)
+    {
+      if (chunk[i] != 0xFF) return false;
+    }
+  }
+  return true;
+
+} // isBlank()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashStorage::eraseIfUsed(uint32_t sector)
+{
+  if (isBlank(sector)) return true;
+  return _flash.eraseSector(sector);
+
+} // eraseIfUsed()
+
+//-------------------------------------------------------------------------------------
+//-- a write that needs bits from 0 to 1 (a slot cleared by init() that is used
+//-- again): keep the rest of the sector, erase it and write it back
+boolean ESPSL_FlashStorage::rewriteSector(uint32_t sector, uint32_t offset, const uint8_t *data, size_t len)
+{
+  uint8_t  *buff;
+  uint32_t  page;
+  boolean   isOK = true;
+
+  buff = (uint8_t*)malloc(_flash.sectorSize());
+  if (buff == NULL) return false;
+  if (!_flash.read((sector * _flash.sectorSize()), buff, _flash.sectorSize()) || !_flash.eraseSector(sector))
+  {
+    free(buff);
+    return false;
+  }
+  memcpy(&buff[offset], data, len);
+  for (page = 0; isOK && (page < _flash.sectorSize()); page += ESPSL_FLASHPAGE)
+  {
+    isOK = _flash.program(((sector * _flash.sectorSize()) + page), &buff[page], ESPSL_FLASHPAGE);
+  }
+  free(buff);
+  return isOK;
+
+} // rewriteSector()
+
+//-------------------------------------------------------------------------------------
+//-- write slot data. Entering a sector erases the next one (after the last
+//-- sector of the ring the first one), that sector only has the oldest lines.
+//-- Zero's (an empty slot) on erased flash (also an empty slot) are skipped.
+boolean ESPSL_FlashStorage::programData(uint32_t dataOffset, const uint8_t *data, size_t len)
+{
+  uint8_t   old[_BLANKCHUNK];
+  uint32_t  addr, sector, nextSector, piece, n, i;
+  boolean   canProgram, blank, zero;
+
+  while (len > 0)
+  {
+    addr   = (_JOURNALSECTORS * _flash.sectorSize()) + dataOffset;
+    sector = (addr / _flash.sectorSize());
+    piece  = (_flash.sectorSize() - (addr % _flash.sectorSize()));
+    if (piece > len) { piece = len; }
+
+    if ((int32_t)sector != _curSector)
+    {
+      _curSector = sector;
+      nextSector = sector +1;
+      if (((nextSector - _JOURNALSECTORS) * _flash.sectorSize()) >= ringBytes()) { nextSector = _JOURNALSECTORS; }
+      if ((nextSector != sector) && !eraseIfUsed(nextSector)) return false;
+    }
+
+    canProgram = true;
+    blank      = true;
+    zero       = true;
+    for (i = 0; i < piece; i += n)
+    {
+      n = ((piece - i) < sizeof(old) ? (piece - i) : sizeof(old));
+      if (!_flash.read((addr + i), old, n)) return false;
+      for (uint32_t b = 0; b < n; b++)
+      {
+        if (data[i + b] & ~old[b])  { canProgram = false; }
+        if (old[b]      != 0xFF)    { blank      = false; }
+        if (data[i + b] != 0x00)    { zero       = false; }
+      }
+    }
+
+    if (!(blank && zero))
+    {
+      if (canProgram)
+      {
+        //-- one program per flash page
+        for (i = 0; i < piece; i += n)
+        {
+          n = (ESPSL_FLASHPAGE - ((addr + i) % ESPSL_FLASHPAGE));
+          if (n > (piece - i)) { n = (piece - i); }
+          if (!_flash.program((addr + i), &data[i], n)) return false;
+        }
+      }
+      else if (!rewriteSector(sector, (addr % _flash.sectorSize()), data, piece))
+      {
+        return false;
+      }
+    }
+    dataOffset += piece;
+    data       += piece;
+    len        -= piece;
+  }
+  return true;
+
+} // programData()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashStorage::exists(const char *fileName)
+{
+  if (strcmp(fileName, _fileName) != 0) return false;
+  return loadHeader();
+
+} // exists()
+
+//-------------------------------------------------------------------------------------
+//-- only the journal is erased, the data sectors are erased by the next open(create)
+boolean ESPSL_FlashStorage::remove(const char *fileName)
+{
+  if (strcmp(fileName, _fileName) != 0) return false;
+  for (uint8_t fd = 0; fd < ESPSL_MAXFILES; fd++) { _isOpen[fd] = false; }
+  for (uint8_t j = 0; j < _JOURNALSECTORS; j++)
+  {
+    if (!eraseIfUsed(j)) return false;
+  }
+  _hasHeader = false;
+  _seq       = 0;
+  _jSector   = 0;
+  _jNext     = 0;
+  return true;
+
+} // remove()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashStorage::open(uint8_t fd, const char *fileName, boolean create)
+{
+  if ((fd >= ESPSL_MAXFILES) || (strcmp(fileName, _fileName) != 0) || (capacity() == 0)) return false;
+  if (create)
+  {
+    remove(fileName);
+    for (uint32_t s = _JOURNALSECTORS; s < _flash.numSectors(); s++)
+    {
+      if (!eraseIfUsed(s)) return false;
+    }
+    _curSector = -1;
+  }
+  else if (!loadHeader())
+  {
+    return false;
+  }
+  _isOpen[fd] = true;
+  return true;
+
+} // open()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_FlashStorage::close(uint8_t fd)
+{
+  if (fd < ESPSL_MAXFILES) { _isOpen[fd] = false; }
+
+} // close()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FlashStorage::isOpen(uint8_t fd)
+{
+  return ((fd < ESPSL_MAXFILES) && _isOpen[fd]);
+
+} // isOpen()
+
+//-------------------------------------------------------------------------------------
+//-- the file always has all its slots (numLines x recLength in the header)
+int32_t ESPSL_FlashStorage::size(uint8_t fd)
+{
+  if (!isOpen(fd))  return -1;
+  if (!_hasHeader)  return 0;
+
+  return (int32_t)(sizeof(ESPSL_fileHeader) + ringBytes());
+
+} // size()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_FlashStorage::readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len)
+{
+  int32_t  fileSize = size(fd);
+  uint32_t n;
+
+  if (fileSize < 0) return -1;
+  if (offset >= (uint32_t)fileSize) return 0;
+  if (len > (fileSize - offset)) { len = (fileSize - offset); }
+
+  n = 0;
+  if (offset < sizeof(ESPSL_fileHeader))
+  {
+    n = (sizeof(ESPSL_fileHeader) - offset);
+    if (n > len) { n = len; }
+    memcpy(data, &((uint8_t*)&_fileHdr)[offset], n);
+  }
+  if ((n < len) && !_flash.read(((_JOURNALSECTORS * _flash.sectorSize()) + (offset + n - sizeof(ESPSL_fileHeader)))
+                                    , &data[n], (len - n)))
+  {
+    return -1;
+  }
+  return (int32_t)len;
+
+} // readAt()
+
+//-------------------------------------------------------------------------------------
+size_t ESPSL_FlashStorage::writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len)
+{
+  uint32_t n = 0;
+
+  if (!isOpen(fd) || ((offset + len) > (sizeof(ESPSL_fileHeader) + capacity()))) return 0;
+
+  if (offset < sizeof(ESPSL_fileHeader))
+  {
+    n = (sizeof(ESPSL_fileHeader) - offset);
+    if (n > len) { n = len; }
+    memcpy(&((uint8_t*)&_fileHdr)[offset], data, n);
+    _hasHeader = true;
+    if (!saveHeader()) return 0;
+  }
+  if ((n < len) && !programData((offset + n - sizeof(ESPSL_fileHeader)), &data[n], (len - n))) return n;
+
+  return len;
+
+} // writeAt()
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+* 
+***************************************************************************/
@@ -0,0 +1,177 @@
+/*
+**  Program   : ESPSL_Flash.h
+**
+**  Version   : 2.0.1   (20-12-2022)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_FLASH_H
+#define _ESPSL_FLASH_H
+
+#include "LittleFS_SysLogger.h"
+#if defined(ESP32)
+  #include <esp_partition.h>
+#endif
+
+#define ESPSL_FLASHPAGE   256   // bytes a page program can write at once
+
+//-------------------------------------------------------------------------------------
+//-- raw NOR flash: an erase sets a whole sector to 0xFF, a program can only
+//-- turn bits from 1 into 0
+class ESPSL_Flash {
+
+public:
+  virtual ~ESPSL_Flash() { }
+
+  virtual uint32_t  sectorSize() = 0;
+  virtual uint32_t  numSectors() = 0;
+  virtual boolean   read(uint32_t addr, uint8_t *data, size_t len) = 0;
+  virtual boolean   program(uint32_t addr, const uint8_t *data, size_t len) = 0;
+  virtual boolean   eraseSector(uint32_t sector) = 0;
+
+};
+
+//-------------------------------------------------------------------------------------
+//-- flash image in RAM with the same erase/program rules, counts every erase
+//-- (per sector) and programmed page to test and benchmark on a PC
+class ESPSL_FlashEmulator : public ESPSL_Flash {
+
+public:
+  ESPSL_FlashEmulator(uint32_t numSectors, uint32_t sectorSize = 4096);
+  ~ESPSL_FlashEmulator();
+
+  uint32_t  sectorSize()  { return _sectorSize; }
+  uint32_t  numSectors()  { return _numSectors; }
+  boolean   read(uint32_t addr, uint8_t *data, size_t len);
+  boolean   program(uint32_t addr, const uint8_t *data, size_t len);
+  boolean   eraseSector(uint32_t sector);
+
+  uint32_t  erases();                       // all sectors together
+  uint32_t  erases(uint32_t sector)         { return ((_erases && (sector < _numSectors)) ? _erases[sector] : 0); }
+  uint32_t  programmedPages()               { return _pages; }
+  uint32_t  programmedBytes()               { return _bytes; }
+  uint32_t  failedPrograms()                { return _failed; }   // tried to turn a 0 into a 1
+  void      resetCounters();
+
+private:
+  uint8_t    *_image;
+  uint32_t   *_erases;
+  uint32_t    _numSectors;
+  uint32_t    _sectorSize;
+  uint32_t    _pages  = 0;
+  uint32_t    _bytes  = 0;
+  uint32_t    _failed = 0;
+
+};
+
+//-------------------------------------------------------------------------------------
+//-- a data partition (ESP32, by label) or a flash area (ESP8266, start address
+//-- and size, sector aligned) that is not used by anything else
+class ESPSL_PartitionFlash : public ESPSL_Flash {
+
+public:
+#if defined(ESP32)
+  ESPSL_PartitionFlash(const char *label);
+#else
+  ESPSL_PartitionFlash(uint32_t startAddr, uint32_t size);
+#endif
+
+  uint32_t  sectorSize()  { return 4096; }
+  uint32_t  numSectors()  { return (_size / 4096); }
+  boolean   read(uint32_t addr, uint8_t *data, size_t len);
+  boolean   program(uint32_t addr, const uint8_t *data, size_t len);
+  boolean   eraseSector(uint32_t sector);
+
+private:
+#if defined(ESP32)
+  const esp_partition_t *_partition;
+#else
+  uint32_t    _startAddr;
+#endif
+  uint32_t    _size;
+
+};
+
+//-------------------------------------------------------------------------------------
+//-- the sysLog file straight on flash, without a filesystem. The slots are
+//-- written in lineID order so the data sectors are written as an append-only
+//-- log: the sector after the one being written is erased ahead, nothing is
+//-- rewritten in place. The file header (cursor) is appended to a journal in
+//-- the first two sectors. Only one file (fileName), resizeLog() is not possible.
+class ESPSL_FlashStorage : public ESPSL_Storage {
+
+public:
+  ESPSL_FlashStorage(ESPSL_Flash &flash, const char *fileName = "/sysLog.dat");
+
+  boolean   exists(const char *fileName);
+  boolean   remove(const char *fileName);
+  boolean   rename(const char * /*fromName*/, const char * /*toName*/)  { return false; }
+  boolean   open(uint8_t fd, const char *fileName, boolean create);
+  void      close(uint8_t fd);
+  boolean   isOpen(uint8_t fd);
+  int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len);
+  size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len);
+  void      flush(uint8_t /*fd*/) { }
+  int32_t   size(uint8_t fd);
+  boolean   truncate(uint8_t /*fd*/, uint32_t /*newSize*/)      { return false; }
+  uint32_t  maxFileSize()       { return (sizeof(ESPSL_fileHeader) + capacity()); }
+
+  uint32_t  capacity();         // bytes for slots (after the journal sectors)
+
+private:
+  //-- one copy of the file header in the journal
+  struct ESPSL_journalEntry {
+    uint32_t    seq;            // 0xFFFFFFFF: never written
+    uint8_t     fileHdr[sizeof(ESPSL_fileHeader)];
+    uint32_t    check;
+    uint32_t    unused[2];
+  };
+
+  ESPSL_Flash      &_flash;
+  const char       *_fileName;
+  boolean           _isOpen[ESPSL_MAXFILES] = { false, false };
+  ESPSL_fileHeader  _fileHdr;
+  boolean           _hasHeader = false;
+  uint32_t          _seq       = 0;
+  uint8_t           _jSector   = 0;       // journal sector in use (0 or 1)
+  uint32_t          _jNext     = 0;       // next free entry in _jSector
+  int32_t           _curSector = -1;      // data sector of the last write
+
+  boolean     loadHeader();
+  boolean     saveHeader();
+  uint32_t    entryCheck(const ESPSL_journalEntry *entry);
+  uint32_t    ringBytes();
+  boolean     isBlank(uint32_t sector);
+  boolean     eraseIfUsed(uint32_t sector);
+  boolean     programData(uint32_t dataOffset, const uint8_t *data, size_t len);
+  boolean     rewriteSector(uint32_t sector, uint32_t offset, const uint8_t *data, size_t len);
+
+};
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+* 
+***************************************************************************/
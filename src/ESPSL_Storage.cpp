@@ -0,0 +1,466 @@
+/***************************************************************************
+**  Program   : ESPSL_Storage.cpp
+**
+**  Version   : 2.0.1   (20-12-2022)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+****************************************************************************
+*/
+
+#include "ESPSL_Storage.h"
+#if !defined(ESP8266)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/stat.h>
+#endif
+
+//=====================================================================================
+//-- ESPSL_FSStorage: a file on a fs::FS (LittleFS)
+//=====================================================================================
+boolean ESPSL_FSStorage::exists(const char *fileName)
+{
+  return _fs.exists(fileName);
+
+} // exists()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FSStorage::remove(const char *fileName)
+{
+  return _fs.remove(fileName);
+
+} // remove()
+
+//-------------------------------------------------------------------------------------
+//-- LittleFS replaces toName, a filesystem that does not (SPIFFS) gets it removed first
+boolean ESPSL_FSStorage::rename(const char *fromName, const char *toName)
+{
+  if (_fs.rename(fromName, toName)) return true;
+  if (!_fs.exists(toName))          return false;
+  _fs.remove(toName);
+  return _fs.rename(fromName, toName);
+
+} // rename()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FSStorage::open(uint8_t fd, const char *fileName, boolean create)
+{
+  if (fd >= ESPSL_MAXFILES) return false;
+  if (_file[fd]) { _file[fd].close(); }
+  _file[fd] = _fs.open(fileName, (create ? "w+" : "r+"));    //-- open for reading and writing
+
+  return (_file[fd] ? true : false);
+
+} // open()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_FSStorage::close(uint8_t fd)
+{
+  if (fd < ESPSL_MAXFILES) { _file[fd].close(); }
+
+} // close()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_FSStorage::isOpen(uint8_t fd)
+{
+  return ((fd < ESPSL_MAXFILES) && _file[fd]);
+
+} // isOpen()
+
+//-------------------------------------------------------------------------------------
+//-- only seek if the file is not already there (the next slot after a
+//-- read or write of the previous one)
+boolean ESPSL_FSStorage::seekTo(uint8_t fd, uint32_t offset)
+{
+  if ((fd >= ESPSL_MAXFILES) || !_file[fd]) return false;
+  if (_file[fd].position() == offset)       return true;
+
+  return _file[fd].seek(offset, SeekSet);
+
+} // seekTo()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_FSStorage::readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len)
+{
+  if (!seekTo(fd, offset)) return -1;
+
+  return (int32_t)_file[fd].read(data, len);
+
+} // readAt()
+
+//-------------------------------------------------------------------------------------
+size_t ESPSL_FSStorage::writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len)
+{
+  if (!seekTo(fd, offset)) return 0;
+
+  return _file[fd].write(data, len);
+
+} // writeAt()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_FSStorage::flush(uint8_t fd)
+{
+  if (isOpen(fd)) { _file[fd].flush(); }
+
+} // flush()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_FSStorage::size(uint8_t fd)
+{
+  if (!isOpen(fd)) return -1;
+
+  return (int32_t)_file[fd].size();
+
+} // size()
+
+//-------------------------------------------------------------------------------------
+//-- the ESP32 fs::File can not truncate
+boolean ESPSL_FSStorage::truncate(uint8_t fd, uint32_t newSize)
+{
+#if defined(ESP8266)
+  if (!isOpen(fd)) return false;
+  return _file[fd].truncate(newSize);
+#else
+  (void)fd;
+  (void)newSize;
+  return false;
+#endif
+
+} // truncate()
+
+
+//=====================================================================================
+//-- ESPSL_RamStorage: files in a malloc()'d buffer
+//=====================================================================================
+ESPSL_RamStorage::ESPSL_RamStorage(uint32_t maxBytes)
+{
+  _maxBytes = maxBytes;
+
+} // ESPSL_RamStorage()
+
+//-------------------------------------------------------------------------------------
+ESPSL_RamStorage::~ESPSL_RamStorage()
+{
+  for (uint16_t f = 0; f < _maxFiles; f++) { free(_ramFile[f].data); }
+  free(_ramFile);
+
+} // ~ESPSL_RamStorage()
+
+//-------------------------------------------------------------------------------------
+int16_t ESPSL_RamStorage::findFile(const char *fileName)
+{
+  for (int16_t f = 0; f < _maxFiles; f++)
+  {
+    if ((_ramFile[f].name[0] != 0) && (strcmp(_ramFile[f].name, fileName) == 0)) return f;
+  }
+  return -1;
+
+} // findFile()
+
+//-------------------------------------------------------------------------------------
+uint32_t ESPSL_RamStorage::usedBytes()
+{
+  uint32_t used = 0;
+
+  for (uint16_t f = 0; f < _maxFiles; f++) { used += _ramFile[f].room; }
+  return used;
+
+} // usedBytes()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::exists(const char *fileName)
+{
+  return (findFile(fileName) >= 0);
+
+} // exists()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::remove(const char *fileName)
+{
+  int16_t f = findFile(fileName);
+
+  if (f < 0) return false;
+  for (uint8_t fd = 0; fd < ESPSL_MAXFILES; fd++)
+  {
+    if (_open[fd] == f) { _open[fd] = -1; }
+  }
+  free(_ramFile[f].data);
+  memset(&_ramFile[f], 0, sizeof(ESPSL_ramFile));
+  return true;
+
+} // remove()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::rename(const char *fromName, const char *toName)
+{
+  int16_t f = findFile(fromName);
+
+  if ((f < 0) || (strlen(toName) >= sizeof(_ramFile[f].name))) return false;
+  if (findFile(toName) >= 0) { remove(toName); }
+  strcpy(_ramFile[f].name, toName);
+  return true;
+
+} // rename()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::open(uint8_t fd, const char *fileName, boolean create)
+{
+  int16_t f;
+
+  if ((fd >= ESPSL_MAXFILES) || (strlen(fileName) >= sizeof(_ramFile[0].name))) return false;
+  _open[fd] = -1;
+  f = findFile(fileName);
+  if ((f < 0) && !create) return false;
+  if (f < 0)
+  {
+    for (f = 0; (f < _maxFiles) && (_ramFile[f].name[0] != 0); f++) { }
+    if (f >= _maxFiles)
+    {
+      //-- the file table is full, make it twice as big
+      uint16_t       newMax = (_maxFiles > 0 ? (2 * _maxFiles) : ESPSL_RAMFILES);
+      ESPSL_ramFile *newTable;
+
+      if (_maxFiles >= 0x4000) return false;
+      newTable = (ESPSL_ramFile*)realloc(_ramFile, (newMax * sizeof(ESPSL_ramFile)));
+      if (newTable == NULL) return false;
+      memset(&newTable[_maxFiles], 0, ((newMax - _maxFiles) * sizeof(ESPSL_ramFile)));
+      _ramFile  = newTable;
+      _maxFiles = newMax;
+    }
+    strcpy(_ramFile[f].name, fileName);
+  }
+  if (create) { _ramFile[f].size = 0; }
+  _open[fd] = f;
+  return true;
+
+} // open()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_RamStorage::close(uint8_t fd)
+{
+  if (fd < ESPSL_MAXFILES) { _open[fd] = -1; }
+
+} // close()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::isOpen(uint8_t fd)
+{
+  return ((fd < ESPSL_MAXFILES) && (_open[fd] >= 0));
+
+} // isOpen()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_RamStorage::readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len)
+{
+  ESPSL_ramFile *file;
+
+  if (!isOpen(fd)) return -1;
+  file = &_ramFile[_open[fd]];
+  if (offset >= file->size) return 0;
+  if (len > (file->size - offset)) { len = (file->size - offset); }
+  memcpy(data, &file->data[offset], len);
+  return (int32_t)len;
+
+} // readAt()
+
+//-------------------------------------------------------------------------------------
+//-- the buffer grows in steps of (at least) 1kB, past the end of the file
+//-- it is filled up with zero's
+size_t ESPSL_RamStorage::writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len)
+{
+  ESPSL_ramFile *file;
+  uint8_t       *newData;
+  uint32_t       newRoom, others;
+
+  if (!isOpen(fd) || (offset > _maxBytes) || (len > (_maxBytes - offset))) return 0;
+  file = &_ramFile[_open[fd]];
+  if ((offset + len) > file->room)
+  {
+    //-- offset + len is at most _maxBytes, so is the room of the other files
+    others  = (usedBytes() - file->room);
+    if (others >= _maxBytes) return 0;
+    newRoom = ((offset + len + 1023) & ~1023);
+    if (newRoom < (2 * file->room))     { newRoom = (2 * file->room); }
+    if (newRoom > (_maxBytes - others)) { newRoom = (_maxBytes - others); }
+    if ((offset + len) > newRoom) return 0;
+    newData = (uint8_t*)realloc(file->data, newRoom);
+    if (newData == NULL) return 0;
+    file->data = newData;
+    file->room = newRoom;
+  }
+  if (offset > file->size) { memset(&file->data[file->size], 0, (offset - file->size)); }
+  memcpy(&file->data[offset], data, len);
+  if ((offset + len) > file->size) { file->size = (offset + len); }
+  return len;
+
+} // writeAt()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_RamStorage::size(uint8_t fd)
+{
+  if (!isOpen(fd)) return -1;
+
+  return (int32_t)_ramFile[_open[fd]].size;
+
+} // size()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_RamStorage::truncate(uint8_t fd, uint32_t newSize)
+{
+  if (!isOpen(fd) || (newSize > _ramFile[_open[fd]].size)) return false;
+  _ramFile[_open[fd]].size = newSize;
+  return true;
+
+} // truncate()
+
+
+#if !defined(ESP8266)
+//=====================================================================================
+//-- ESPSL_PosixStorage: pread()/pwrite() on a file descriptor
+//=====================================================================================
+ESPSL_PosixStorage::~ESPSL_PosixStorage()
+{
+  for (uint8_t fd = 0; fd < ESPSL_MAXFILES; fd++) { close(fd); }
+
+} // ~ESPSL_PosixStorage()
+
+//-------------------------------------------------------------------------------------
+const char *ESPSL_PosixStorage::fullPath(const char *fileName, char *path, size_t pathLen)
+{
+  snprintf(path, pathLen, "%s%s", _root, fileName);
+  return path;
+
+} // fullPath()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::exists(const char *fileName)
+{
+  char        path[80];
+  struct stat st;
+
+  return (::stat(fullPath(fileName, path, sizeof(path)), &st) == 0);
+
+} // exists()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::remove(const char *fileName)
+{
+  char path[80];
+
+  return (::unlink(fullPath(fileName, path, sizeof(path))) == 0);
+
+} // remove()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::rename(const char *fromName, const char *toName)
+{
+  char fromPath[80], toPath[80];
+
+  return (::rename(fullPath(fromName, fromPath, sizeof(fromPath))
+                 , fullPath(toName,   toPath,   sizeof(toPath))) == 0);
+
+} // rename()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::open(uint8_t fd, const char *fileName, boolean create)
+{
+  char path[80];
+
+  if (fd >= ESPSL_MAXFILES) return false;
+  close(fd);
+  _fd[fd] = ::open(fullPath(fileName, path, sizeof(path)), (create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR), 0644);
+
+  return (_fd[fd] >= 0);
+
+} // open()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_PosixStorage::close(uint8_t fd)
+{
+  if ((fd < ESPSL_MAXFILES) && (_fd[fd] >= 0))
+  {
+    ::close(_fd[fd]);
+    _fd[fd] = -1;
+  }
+
+} // close()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::isOpen(uint8_t fd)
+{
+  return ((fd < ESPSL_MAXFILES) && (_fd[fd] >= 0));
+
+} // isOpen()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_PosixStorage::readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len)
+{
+  if (!isOpen(fd)) return -1;
+
+  return (int32_t)::pread(_fd[fd], data, len, offset);
+
+} // readAt()
+
+//-------------------------------------------------------------------------------------
+size_t ESPSL_PosixStorage::writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len)
+{
+  ssize_t bytesWritten;
+
+  if (!isOpen(fd)) return 0;
+  bytesWritten = ::pwrite(_fd[fd], data, len, offset);
+
+  return (bytesWritten < 0 ? 0 : (size_t)bytesWritten);
+
+} // writeAt()
+
+//-------------------------------------------------------------------------------------
+void ESPSL_PosixStorage::flush(uint8_t fd)
+{
+  if (isOpen(fd)) { ::fsync(_fd[fd]); }
+
+} // flush()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL_PosixStorage::size(uint8_t fd)
+{
+  struct stat st;
+
+  if (!isOpen(fd) || (::fstat(_fd[fd], &st) != 0)) return -1;
+
+  return (int32_t)st.st_size;
+
+} // size()
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL_PosixStorage::truncate(uint8_t fd, uint32_t newSize)
+{
+  if (!isOpen(fd)) return false;
+
+  return (::ftruncate(_fd[fd], newSize) == 0);
+
+} // truncate()
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+* 
+***************************************************************************/
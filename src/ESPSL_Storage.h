@@ -0,0 +1,168 @@
+/*
+**  Program   : ESPSL_Storage.h
+**
+**  Version   : 2.0.1   (20-12-2022)
+**
+**  Copyright (c) 2022 .. 2023 Willem Aandewiel
+**
+**  TERMS OF USE: MIT License. See bottom of file.
+***************************************************************************/
+
+#ifndef _ESPSL_STORAGE_H
+#define _ESPSL_STORAGE_H
+
+#include <FS.h>
+#include <LittleFS.h>
+
+#define ESPSL_MAXFILES  2     // open files: the sysLog file and the one resizeLog() copies to
+#define ESPSL_RAMFILES  4     // files in the first file table of an ESPSL_RamStorage
+
+//-------------------------------------------------------------------------------------
+//-- where the sysLog file lives. All access is positional (readAt/writeAt) on
+//-- one of ESPSL_MAXFILES file descriptors (fd 0 .. ESPSL_MAXFILES-1)
+class ESPSL_Storage {
+
+public:
+  virtual ~ESPSL_Storage() { }
+
+  virtual boolean   exists(const char *fileName) = 0;
+  virtual boolean   remove(const char *fileName) = 0;
+  //-- an existing toName is replaced
+  virtual boolean   rename(const char *fromName, const char *toName) = 0;
+  //-- create == true: start with an empty file
+  virtual boolean   open(uint8_t fd, const char *fileName, boolean create) = 0;
+  virtual void      close(uint8_t fd) = 0;
+  virtual boolean   isOpen(uint8_t fd) = 0;
+  virtual int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len) = 0;
+  virtual size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len) = 0;
+  virtual void      flush(uint8_t fd) = 0;
+  virtual int32_t   size(uint8_t fd) = 0;
+  virtual boolean   truncate(uint8_t fd, uint32_t newSize) = 0;
+  //-- the largest file the storage can hold, 0: only limited by free space
+  virtual uint32_t  maxFileSize()   { return 0; }
+
+};
+
+//-------------------------------------------------------------------------------------
+//-- a file on LittleFS (default), SPIFFS, SD, FFat .. (any fs::FS)
+class ESPSL_FSStorage : public ESPSL_Storage {
+
+public:
+  ESPSL_FSStorage(fs::FS &fileSys = LittleFS) : _fs(fileSys) { }
+
+  boolean   exists(const char *fileName);
+  boolean   remove(const char *fileName);
+  boolean   rename(const char *fromName, const char *toName);
+  boolean   open(uint8_t fd, const char *fileName, boolean create);
+  void      close(uint8_t fd);
+  boolean   isOpen(uint8_t fd);
+  int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len);
+  size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len);
+  void      flush(uint8_t fd);
+  int32_t   size(uint8_t fd);
+  boolean   truncate(uint8_t fd, uint32_t newSize);
+
+private:
+  fs::FS     &_fs;
+  File        _file[ESPSL_MAXFILES];
+
+  boolean     seekTo(uint8_t fd, uint32_t offset);
+
+};
+
+//-------------------------------------------------------------------------------------
+//-- files in RAM (lost at reset), for hot debugging. All files together
+//-- never take more than maxBytes of heap. The file table grows with the
+//-- number of files (segment files, the copy of resizeLog())
+class ESPSL_RamStorage : public ESPSL_Storage {
+
+public:
+  ESPSL_RamStorage(uint32_t maxBytes);
+  ~ESPSL_RamStorage();
+  ESPSL_RamStorage(const ESPSL_RamStorage&) = delete;
+  ESPSL_RamStorage &operator=(const ESPSL_RamStorage&) = delete;
+
+  boolean   exists(const char *fileName);
+  boolean   remove(const char *fileName);
+  boolean   rename(const char *fromName, const char *toName);
+  boolean   open(uint8_t fd, const char *fileName, boolean create);
+  void      close(uint8_t fd);
+  boolean   isOpen(uint8_t fd);
+  int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len);
+  size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len);
+  void      flush(uint8_t /*fd*/) { }
+  int32_t   size(uint8_t fd);
+  boolean   truncate(uint8_t fd, uint32_t newSize);
+
+private:
+  struct ESPSL_ramFile {
+    char      name[32];
+    uint8_t  *data;
+    uint32_t  size;
+    uint32_t  room;
+  };
+  ESPSL_ramFile *_ramFile  = NULL;
+  uint16_t      _maxFiles = 0;    // entries in _ramFile
+  int16_t       _open[ESPSL_MAXFILES] = { -1, -1 };
+  uint32_t      _maxBytes;
+
+  int16_t       findFile(const char *fileName);
+  uint32_t      usedBytes();
+
+};
+
+#if !defined(ESP8266)
+//-------------------------------------------------------------------------------------
+//-- a POSIX file (pread/pwrite), on the ESP32 through the VFS (root "/littlefs")
+//-- or on a PC to test and benchmark the logger
+class ESPSL_PosixStorage : public ESPSL_Storage {
+
+public:
+  ESPSL_PosixStorage(const char *rootDir = "") : _root(rootDir) { }
+  ~ESPSL_PosixStorage();
+
+  boolean   exists(const char *fileName);
+  boolean   remove(const char *fileName);
+  boolean   rename(const char *fromName, const char *toName);
+  boolean   open(uint8_t fd, const char *fileName, boolean create);
+  void      close(uint8_t fd);
+  boolean   isOpen(uint8_t fd);
+  int32_t   readAt(uint8_t fd, uint32_t offset, uint8_t *data, size_t len);
+  size_t    writeAt(uint8_t fd, uint32_t offset, const uint8_t *data, size_t len);
+  void      flush(uint8_t fd);
+  int32_t   size(uint8_t fd);
+  boolean   truncate(uint8_t fd, uint32_t newSize);
+
+private:
+  const char *_root;
+  int         _fd[ESPSL_MAXFILES] = { -1, -1 };
+
+  const char *fullPath(const char *fileName, char *path, size_t pathLen);
+
+};
+#endif
+
+#endif
+
+/***************************************************************************
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to permit
+* persons to whom the Software is furnished to do so, subject to the
+* following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+* OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+* THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+* 
+***************************************************************************/
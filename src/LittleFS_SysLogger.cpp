@@ -11,90 +11,162 @@
 
 #include "LittleFS_SysLogger.h"
 
-//-- Constructor
+//-- Constructor, the buffers can hold lines of up to _MAXLINEWIDTH chars
 ESPSL::ESPSL() 
+  : ESPSL((char*)malloc(_MAXLINEWIDTH +15)
+        , (uint8_t*)malloc(sizeof(ESPSL_recHeader) + _MAXLINEWIDTH +1)
+        , (uint8_t*)malloc(sizeof(ESPSL_recHeader) + _MAXLINEWIDTH +1)
+        , _MAXLINEWIDTH)
 { 
+  _ownBuffs = true;
+} 
+
+//-------------------------------------------------------------------------------------
+//-- Constructor with buffers for lines of up to bufWidth chars (ESPSL_Fixed)
+ESPSL::ESPSL(char *textBuff, uint8_t *recBuff, uint8_t *workBuff, uint16_t bufWidth) 
+{ 
+  globalBuff = textBuff;
+  _recBuff   = recBuff;
+  _workBuff  = workBuff;
+  _bufWidth  = bufWidth;
+
+  _store    = &_fsStorage;
+  _fd       = 0;
+  _filePos  = 0;
+
   _Serial   = NULL;
   _serialOn = false;
   _Stream   = NULL;
   _streamOn = false;
+
+  _wbBuff     = NULL;
+  _wbMaxLines = 0;
+  _wbCount    = 0;
+  _wbMaxBytes = 0;
+  _wbMaxAge   = 0;
+  _wbStart    = 0;
+
+  _cursorLineID = 0;
+
+  _exportStream   = NULL;
+  _exportThrottle = true;
+  _exportNext     = 0;
+  _exportEnd      = 0;
+
+  resetStats();
 }
 
+//-------------------------------------------------------------------------------------
+//-- Destructor, pending lines are written before the buffers are freed
+ESPSL::~ESPSL()
+{
+#if defined(ESP32)
+  stopWriter();
+#endif
+  commit();
+  free(_wbBuff);
+  freePacked();
+  free(_lzHash);
+  if (_ownBuffs)
+  {
+    free(globalBuff);
+    free(_recBuff);
+    free(_workBuff);
+  }
+
+} // ~ESPSL()
+
 //-------------------------------------------------------------------------------------
 //-- begin object
 boolean ESPSL::begin(uint16_t depth, uint16_t lineWidth) 
 {
-  uint32_t  tmpID, recKey;
-  
+  uint8_t kind;
+
 #ifdef _DODEBUG
   if (_Debug(1)) printf("ESPSL(%d)::begin(%d, %d)..\n", __LINE__, depth, lineWidth);
 #endif
 
-  int16_t fileSize;
-
-  if (lineWidth > _MAXLINEWIDTH) { lineWidth = _MAXLINEWIDTH; }
+  if ((globalBuff == NULL) || (_recBuff == NULL) || (_workBuff == NULL))
+  {
+    printf("ESPSL(%d)::begin(): no line buffers .. bailing out!\r\n", __LINE__);
+    return false;
+  }
+  if (lineWidth > _bufWidth)     { lineWidth = _bufWidth; }
   if (lineWidth < _MINLINEWIDTH) { lineWidth = _MINLINEWIDTH; }
-  memset(globalBuff, 0, (_MAXLINEWIDTH +15));
+
+  //-- pending lines belong to the old geometry, write them out first
+  commit();
+  if (_wbBuff != NULL) 
+  { 
+    free(_wbBuff);
+    _wbBuff = NULL;
+  }
+  _wbCount = 0;   //-- what commit() could not write is lost
+
+  memset(globalBuff, 0, (_bufWidth +15));
+
+  if (_segBytes > 0) return beginSegments(depth, lineWidth);
+  
+  //-- a ring that does not fit the storage (raw flash) leaves the sysLog file as it is
+  if (   (_store->maxFileSize() > 0)
+      && ((sizeof(ESPSL_fileHeader) + ((uint32_t)depth * (sizeof(ESPSL_recHeader) + lineWidth))) > _store->maxFileSize()) )
+  {
+    printf("ESPSL(%d)::begin(%d, %d): needs more than the [%u] bytes of the storage .. bailing out!\r\n"
+                                            , __LINE__, depth, lineWidth, _store->maxFileSize());
+    return false;
+  }
   
   //-- check if the file exists ---
-  if (!LittleFS.exists(_sysLogFile)) 
+  if (!_store->exists(_sysLogFile)) 
   {
     printf("ESPSL(%d)::begin(%d, %d) %s does not exist..\n", __LINE__, depth, lineWidth, _sysLogFile);
-    if (create(depth, lineWidth))
-    {
-      _numLines   = depth;
-      _lineWidth  = lineWidth;
-    }
+    if (!create(depth, lineWidth)) return false;
   }
   
   //-- check if the file can be opened ---
-  _sysLog  = LittleFS.open(_sysLogFile, "r+");    //-- open for reading and writing
-  if (!_sysLog) 
+  if (!_store->open(_fd, _sysLogFile, false))     //-- open for reading and writing
   {
     printf("ESPSL(%d)::begin(): Some error opening [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
     return false;
-  } //-- if (!_sysLog)
+  } //-- if (!open)
 
-  if (_sysLog.available() > 0) 
+  if (!readMetaData())
   {
-#ifdef _DODEBUG
-    if (_Debug(3)) printf("ESPSL(%d)::begin(): read record [0]\r\n", __LINE__);
-#endif
-    if (!_sysLog.seek(0, SeekSet)) 
+    kind = fileType();
+    _store->close(_fd);
+    if (kind == _FILE_VERSION)
     {
-      printf("ESPSL(%d)::begin(): seek to position [%04d] failed (now @%d)\r\n", __LINE__
-                                                                               , 0
-                                                                               , _sysLog.position());
+      //-- written by another version of ESPSL, it is left as it is
+      printf("ESPSL(%d)::begin(): [%s] has another version .. bailing out!\r\n", __LINE__, _sysLogFile);
+      return false;
     }
-
-    int l = _sysLog.readBytesUntil('\n', globalBuff, _MAXLINEWIDTH) -1; 
-        //printf("ESPSL(%d)::begin(): rec[0] [%s]\r\n", __LINE__, globalBuff);
-
-#ifdef _DODEBUG
-        if (_Debug(4)) printf("ESPSL(%d)::begin(): rec[0] [%s]\r\n", __LINE__, globalBuff);
-#endif
-        sscanf(globalBuff,"%u|%d;%d;%d;" 
-                                , &recKey
-                                , &tmpID
-                                , &_numLines
-                                , &_lineWidth);
-     //printf("ESPSL(%d)::begin(): rec[%d] numLines[%d], lineWidth[%d]\r\n", __LINE__
-     //                                                                       , recKey
-     //                                                                       , _numLines
-     //                                                                       , _lineWidth);
-    Serial.flush();
-    if (_numLines   < _MINNUMLINES)  { _numLines   = _MINNUMLINES; }
-    if (_lineWidth  < _MINLINEWIDTH) { _lineWidth  = _MINLINEWIDTH; }
-    _recLength = _lineWidth + _KEYLEN;
-    //if (tmpID > _lastUsedLineID) { _lastUsedLineID = tmpID; }
+    if (kind == _FILE_ASCII)
+    {
+      //-- an old text sysLog file is converted, if that fails it is kept
+      if (!migrateAsciiLog())
+      {
+        printf("ESPSL(%d)::begin(): could not convert [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
+        return false;
+      }
+    }
+    else
+    {
+      //-- not a sysLog file (an empty file or a torn header)
+      removeSysLog();
+      if (!create(depth, lineWidth)) return false;
+    }
+    if (!_store->open(_fd, _sysLogFile, false) || !readMetaData())    //-- open for reading and writing
+    {
+      printf("ESPSL(%d)::begin(): Some error opening [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
+      return false;
+    } //-- if (!open)
+  } 
 #ifdef _DODEBUG
-    if (_Debug(4)) printf("ESPSL(%d)::begin(): rec[%u] -> [%8d][%d][%d]\r\n", __LINE__
-                                                                                , recKey
-                                                                                , _lastUsedLineID
-                                                                                , _numLines
-                                                                                , _lineWidth);
+  if (_Debug(4)) printf("ESPSL(%d)::begin(): header -> [%8d][%d][%d]\r\n", __LINE__
+                                                                         , _cursorLineID
+                                                                         , _numLines
+                                                                         , _lineWidth);
 #endif
-  } 
   
   if ((depth != _numLines) || lineWidth != _lineWidth)
   {
@@ -103,21 +175,24 @@ boolean ESPSL::begin(uint16_t depth, uint16_t lineWidth)
                                               , _numLines
                                               , lineWidth
                                               , _lineWidth);
-    _sysLog.close();
-    removeSysLog();
-    create(depth, lineWidth);
-    _sysLog  = LittleFS.open(_sysLogFile, "r+");    //-- open for reading and writing
-    if (!_sysLog) 
+    //-- keep the history, only if that fails start with an empty sysLog file
+    if (!resizeLog(depth, lineWidth))
+    {
+      _store->close(_fd);
+      removeSysLog();
+      if (!create(depth, lineWidth)) return false;
+    }
+    if (!_store->open(_fd, _sysLogFile, false))     //-- open for reading and writing
     {
       printf("ESPSL(%d)::begin(): Some error opening [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
       return false;
-    } //-- if (!_sysLog)
+    } //-- if (!open)
 
   }
   
-  memset(globalBuff, 0, sizeof(globalBuff));
+  memset(globalBuff, 0, (_bufWidth +15));
   
-  checkSysLogFileSize("begin():", (_numLines + 1) * (_recLength +1));  //-- add '\n'
+  checkSysLogFileSize("begin():", fileSize());
   
   if (_numLines != depth) 
   {
@@ -140,16 +215,16 @@ boolean ESPSL::begin(uint16_t depth, uint16_t lineWidth)
 boolean ESPSL::begin(uint16_t depth, uint16_t lineWidth, boolean mode) 
 {
 #ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%s)::begin(%d, %d, %s)..\n", __LINE__, depth, lineWidth, (mode? "CREATE":"KEEP"));
+  if (_Debug(1)) printf("ESPSL(%d)::begin(%d, %d, %s)..\n", __LINE__, depth, lineWidth, (mode? "CREATE":"KEEP"));
 #endif
   _numLines   = depth;
   _lineWidth  = lineWidth;
   
   if (mode) 
   {
-    _sysLog.close();
+    _store->close(_fd);
     removeSysLog();
-    create(_numLines, _lineWidth);
+    if ((_segBytes == 0) && !create(_numLines, _lineWidth)) return false;
   }
   return (begin(depth, lineWidth));
   
@@ -157,9 +232,10 @@ boolean ESPSL::begin(uint16_t depth, uint16_t lineWidth, boolean mode)
 
 //-------------------------------------------------------------------------------------
 //-- Create a SysLog file on LittleFS
-boolean ESPSL::create(uint16_t depth, uint16_t lineWidth) 
+boolean ESPSL::create(uint16_t depth, uint16_t lineWidth, const char *fileName)
 {
-  File createFile;
+  uint8_t  createFd = (_fd ^ 1);    //-- the sysLog file may still be open (resizeLog())
+  uint32_t offset;
   
 #ifdef _DODEBUG
   if (_Debug(1)) printf("ESPSL(%d)::create(%d, %d)..\n", __LINE__, depth, lineWidth);
@@ -167,496 +243,3057 @@ boolean ESPSL::create(uint16_t depth, uint16_t lineWidth)
 
   int32_t bytesWritten;
   
+  if (fileName == NULL) { fileName = _sysLogFile; }
+
   _numLines   = depth;
-  if (lineWidth > _MAXLINEWIDTH)
-          lineWidth  = _MAXLINEWIDTH;
+  if (lineWidth > _bufWidth)
+          lineWidth  = _bufWidth;
   else if (lineWidth < _MINLINEWIDTH) 
           lineWidth  = _MINLINEWIDTH;
   _lineWidth  = lineWidth;
   
-  _recLength  = _lineWidth + _KEYLEN;
+  _recLength  = sizeof(ESPSL_recHeader) + _lineWidth;
 
-  //_nextFree = 0;
-  memset(globalBuff, 0, sizeof(globalBuff));  
-  //-- check if the file exists and can be opened ---
-  createFile  = LittleFS.open(_sysLogFile, "w");    //-- open for writing
-  if (!createFile) 
+  if ((_store->maxFileSize() > 0) && ((uint32_t)fileSize() > _store->maxFileSize()))
   {
-    printf("ESPSL(%d)::create(): Some error opening [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
-    createFile.close();
+    printf("ESPSL(%d)::create(): [%d] lines of [%d] chars need [%d] bytes, there is room for [%u] .. bailing out!\r\n"
+                                            , __LINE__, _numLines, _lineWidth, fileSize(), _store->maxFileSize());
     return false;
-  } //-- if (!_sysLog)
-
+  }
 
-  snprintf(globalBuff, _lineWidth, "%08d;%d;%d; META DATA LittleFS_SysLogger", 0, _numLines, _lineWidth);
-  fixLineWidth(globalBuff, _lineWidth);
-  fixRecLen(globalBuff, 0, _recLength);
-#ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%d)::create(): rec(0) [%s](%d bytes)\r\n", __LINE__, globalBuff, strlen(globalBuff));
-#endif
-  bytesWritten = createFile.println(globalBuff) -1; //-- skip '\n'
-  createFile.flush();
-  if (bytesWritten != _recLength) 
+  //-- check if the file exists and can be opened ---
+  if (!_store->open(createFd, fileName, true))    //-- open for writing
+  {
+    printf("ESPSL(%d)::create(): Some error opening [%s] .. bailing out!\r\n", __LINE__, fileName);
+    return false;
+  } //-- if (!open)
+
+  ESPSL_fileHeader fileHdr;
+  memset(&fileHdr, 0, sizeof(fileHdr));
+  memcpy(fileHdr.magic, _FILEMAGIC, sizeof(fileHdr.magic));
+  fileHdr.version    = _FILEVERSION;
+  fileHdr.lineWidth  = _lineWidth;
+  fileHdr.numLines   = _numLines;
+  fileHdr.lastLineID = 0;
+  fileHdr.flags      = (_lazyCreate ? _HDR_SPARSE : 0);
+  _fileFlags         = fileHdr.flags;
+  bytesWritten = _store->writeAt(createFd, 0, (uint8_t*)&fileHdr, sizeof(fileHdr));
+  if (bytesWritten != sizeof(fileHdr))
   {
-    printf("ESPSL(%d)::create(): ERROR!! written [%d] bytes but should have been [%d] for record [0]\r\n"
-                                            ,__LINE__ , bytesWritten, _recLength);
+    printf("ESPSL(%d)::create(): ERROR!! written [%d] bytes but should have been [%d] for the header\r\n"
+                                            ,__LINE__ , bytesWritten, sizeof(fileHdr));
 
-    createFile.close();
+    _store->close(createFd);
     return false;
   }
   
+  //-- all slots empty (lineID 0), a sparse file grows when the slots are used
+  memset(_recBuff, 0, (sizeof(ESPSL_recHeader) + _bufWidth +1));
   int r;
-  for (r=0; r < _numLines; r++) 
+  offset = sizeof(fileHdr);
+  for (r=0; (r < _numLines) && !_lazyCreate; r++, offset += _recLength) 
   {
     yield();
-    snprintf(globalBuff, _lineWidth, "=== empty log regel (%d) ========================================================================================", (r+1));
-    fixLineWidth(globalBuff, _lineWidth);
-    fixRecLen(globalBuff, (_EMPTYID *1), _recLength);
-    //printf("ESPSL(%d)::create(): rec(%d) [%s](%d bytes)\r\n", __LINE__, r, globalBuff, strlen(globalBuff));
-    bytesWritten = createFile.println(globalBuff) -1; //-- skip '\n'
+    bytesWritten = _store->writeAt(createFd, offset, _recBuff, _recLength);
     if (bytesWritten != _recLength) 
     {
       printf("ESPSL(%d)::create(): ERROR!! written [%d] bytes but should have been [%d] for record [%d]\r\n"
                                             ,__LINE__ , bytesWritten, _recLength, r);
-      createFile.close();
+      _store->close(createFd);
       return false;
     }
     
   } //-- for r ....
   
-  createFile.close();
+  _store->flush(createFd);
+  _store->close(createFd);
   
-  _lastUsedLineID = 1;
-  _oldestLineID   = 0;
+  _lastUsedLineID = 0;
+  _oldestLineID   = 1;
+  _cursorLineID   = 0;
 
     return true;
   
 } // create()
 
 //-------------------------------------------------------------------------------------
-//-- read SysLog file and find next line to write to
+//-- find next line to write to
 boolean ESPSL::init() 
 {
-  int32_t offset, recKey = 0;
-  int32_t readKey;
-  char logText[(_lineWidth + _KEYLEN +1)];
-  memset(logText, 0, (_lineWidth + _KEYLEN +1));
+  int32_t steps;
 
 #ifdef _DODEBUG
   if (_Debug(1)) printf("ESPSL(%d)::init()..\r\n", __LINE__);
 #endif
       
-  if (!_sysLog) 
+  if (!_store->isOpen(_fd)) 
   {
     printf("ESPSL(%d)::init(): Some error opening [%s] .. bailing out!\r\n", __LINE__, _sysLogFile);
     return false;
-  } //-- if (!_sysLog)
+  } //-- if (!isOpen)
 
   _oldestLineID   = 0;
   _lastUsedLineID = 0;
-  recKey          = 0;
 
-  while (_sysLog.available() > 0) 
+  //-- the cursor in the header is at most _CURSOREVERY lines (or one write-behind
+  //-- batch) behind, only if its own line is gone the whole file is searched
+  if ((_cursorLineID == 0) || (readValidID(_cursorLineID % _numLines) == _cursorLineID))
+  {
+    _lastUsedLineID = _cursorLineID;
+  }
+  else
   {
-    recKey++;
-    offset = (recKey * (_recLength +1)); 
-    if (!_sysLog.seek(offset, SeekSet)) 
+#ifdef _DODEBUG
+    if (_Debug(3)) printf("ESPSL(%d)::init(): cursor [%d] is not valid\r\n", __LINE__, _cursorLineID);
+#endif
+    _lastUsedLineID = findLastUsedLineID();
+    for (steps = 0; (steps < _numLines) && (_lastUsedLineID > 0); steps++)
     {
-      printf("ESPSL(%d)::init(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, recKey
-                                                                                  , offset
-                                                                                  , _sysLog.position());
-      return false;
+      if (readValidID(_lastUsedLineID % _numLines) == _lastUsedLineID) break;
+      _lastUsedLineID--;
     }
+  }
+  if (_lastUsedLineID <= 0) { _lastUsedLineID = 0; }
+
+  //-- lines written after the cursor was saved
+  for (steps = 0; steps < _numLines; steps++)
+  {
+    if (readValidID((_lastUsedLineID +1) % _numLines) != (_lastUsedLineID +1)) break;
+    _lastUsedLineID++;
+  }
+  //-- a torn record (reset while writing) after the last complete line
+  if (readSlotID((_lastUsedLineID +1) % _numLines) == (_lastUsedLineID +1))
+  {
+    printf("ESPSL(%d)::init(): discard torn line [%d]\r\n", __LINE__, (_lastUsedLineID +1));
+    clearSlot((_lastUsedLineID +1) % _numLines);
+  }
 #ifdef _DODEBUG
-    if (_Debug(4)) printf("ESPSL(%d)::init(): -> read record (recKey) [%d/%04d]\r\n", __LINE__, recKey, offset);
+  if (_Debug(3)) printf("ESPSL(%d)::init(): [%d] lines after the cursor\r\n", __LINE__, (_lastUsedLineID - _cursorLineID));
 #endif
-    int l = _sysLog.readBytesUntil('\n', globalBuff, _recLength);
-        sscanf(globalBuff,"%u|%[^\0]" , &_oldestLineID, logText);
-        if (_oldestLineID > 0)
-        {
-          if (_oldestLineID >= _lastUsedLineID) { _lastUsedLineID = _oldestLineID; }
-          //printf("ESPSL(%d):: init() -> _lastUsedLineID[%d] _oldestLineID[%d]\r\n", __LINE__, _lastUsedLineID, _oldestLineID);
-        }
-    
+  _oldestLineID = _lastUsedLineID +1;
+  _cursorLineID = _lastUsedLineID;
 #ifdef _DODEBUG
-    if (_Debug(4)) printf("ESPSL(%d)::init(): testing readKey[%010u] -> [%08d][%s]\r\n", __LINE__
-                                                                                , _oldestLineID
-                                                                                , logText);
+  if (_Debug(3)) printf("ESPSL(%d)::init() => _lastUsedLineID[%d]\r\n", __LINE__, _lastUsedLineID);
 #endif
-  } //-- while ..
-  
-  if (_lastUsedLineID <= 0) { _lastUsedLineID = 0; }
-  _oldestLineID = _lastUsedLineID +1;
-  //printf("ESPSL(%d):: init() => _lastUsedLineID[%d] _oldestLineID[%d]\r\n", __LINE__, _lastUsedLineID, _oldestLineID);
 
-  return false;
+  return true;
 
 } // init()
 
 
 //-------------------------------------------------------------------------------------
-boolean ESPSL::write(const char* logLine) 
+//-- file offset of a slot (slot == lineID % _numLines)
+uint32_t ESPSL::slotOffset(int32_t slot)
+{ 
+  return (sizeof(ESPSL_fileHeader) + (slot * _recLength));
+
+} // slotOffset()
+
+//-------------------------------------------------------------------------------------
+//-- seek to slot to write it, a sparse sysLog file is first filled up with
+//-- empty slots (zero's) if slot is past its end
+boolean ESPSL::seekSlot(int32_t slot)
 {
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d)::write(%s)..\r\n", __LINE__, logLine);
-#endif
+  uint8_t   zeros[64];
+  uint32_t  offset = slotOffset(slot);
+  int32_t   size;
+  int32_t   bytes;
 
-  int32_t   bytesWritten;
-  uint16_t  offset, seekToLine;
-  int       nextFree;
+  if (_segLines > 0) return seekFile(offset);   //-- segmentIO() fills up the segment
 
-  //_sysLog  = LittleFS.open(_sysLogFile, "r+");    //-- open for reading and writing
+  size = _store->size(_fd);
+  if (size < 0) return false;
+  if (offset <= (uint32_t)size) return seekFile(offset);
 
-#ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::write(): oldest[%8d], last[%8d], nextFree Slot[%3d]\r\n"
-                                                      , __LINE__
-                                                      , _oldestLineID
-                                                      , _lastUsedLineID
-                                                      , nextFree);
-#endif
-  
-  char lineBuff[(_recLength + _KEYLEN +1)];
-  memset(globalBuff, 0, (_recLength + _KEYLEN + 1));
+  if (!seekFile(size)) return false;
+  memset(zeros, 0, sizeof(zeros));
+  while ((uint32_t)size < offset)
+  {
+    bytes = ((offset - size) < sizeof(zeros) ? (offset - size) : sizeof(zeros));
+    if (writeFile(zeros, bytes) != (size_t)bytes) return false;
+    size += bytes;
+  }
+  return true;
 
-  snprintf(globalBuff, _lineWidth, "%s", logLine);
-  fixLineWidth(globalBuff, _lineWidth); 
-  _lastUsedLineID++;
-  fixRecLen(globalBuff, _lastUsedLineID, _recLength);
-  seekToLine = (_lastUsedLineID % _numLines) +1; //-- always skip rec. 0 (status rec)
-  offset = (seekToLine * (_recLength +1));
+} // seekSlot()
+
+//-------------------------------------------------------------------------------------
+//-- all seeks, reads, writes and flushes of the sysLog file go through these
+//-- (counters). Reads and writes are positional at _filePos, a seek only
+//-- counts if it moves away from where the previous read or write ended
+boolean ESPSL::seekFile(uint32_t offset)
+{
+  _STAT(if (offset != _filePos) _stats.seeks++);
+  _filePos = offset;
+  return ((_segLines > 0) || _store->isOpen(_fd));   //-- segmentIO() opens the segments
+
+} // seekFile()
+
+//-------------------------------------------------------------------------------------
+int32_t ESPSL::readFile(uint8_t *data, size_t len)
+{
+  int32_t bytesRead;
+
+  if (_segLines > 0) return segmentIO(data, len, false);
+
+  bytesRead = _store->readAt(_fd, _filePos, data, len);
+  if (bytesRead > 0) { _filePos += bytesRead; }
+  return bytesRead;
+
+} // readFile()
+
+//-------------------------------------------------------------------------------------
+size_t ESPSL::writeFile(const uint8_t *data, size_t len)
+{
+  size_t bytesWritten;
+
+  if (_segLines > 0)
+  {
+    bytesWritten = segmentIO((uint8_t*)data, len, true);
+  }
+  else
+  {
+    bytesWritten = _store->writeAt(_fd, _filePos, data, len);
+    _filePos += bytesWritten;
+  }
+  //-- appendPacked() counts the bytes it really writes
+  _STAT(if (!_segPacked || (_segLines == 0)) _stats.bytesWritten += bytesWritten);
+  _STAT(if (bytesWritten != len) _stats.failedWrites++);
+  return bytesWritten;
+
+} // writeFile()
+
+//-------------------------------------------------------------------------------------
+void ESPSL::syncFile()
+{
+  _STAT(_stats.flushes++);
+  _store->flush(_fd);
+
+} // syncFile()
+
+
+//-------------------------------------------------------------------------------------
+//-- segmented sysLog (setSegments()): the ring of slots is split over _numSegs
+//-- segment files of _segLines slots. One segment more than depth needs is
+//-- kept, the oldest one is dropped as a whole when the ring gets back to it.
+//-- Only the segment headers are read, the last line is found from the size
+//-- of the newest segment. Packed segments hold as many records as fit in
+//-- segmentBytes, together as much flash as depth full slots; the newest
+//-- segment is scanned for its last (valid) record.
+boolean ESPSL::beginSegments(uint16_t depth, uint16_t lineWidth)
+{
+  ESPSL_fileHeader fileHdr;
+  char             segName[_SEGNAMELEN];
+  int32_t          seg, size;
+  int32_t          newestSeg  = -1;
+  int32_t          newestSize = 0;
+  uint32_t         newestID   = 0;
+  uint32_t         segData;
+  boolean          isValid    = true;
+
+  if (depth < _MINNUMLINES) { depth = _MINNUMLINES; }
+  _lineWidth = lineWidth;
+  _recLength = sizeof(ESPSL_recHeader) + _lineWidth;
+  if (_segPacked)
+  {
+    //-- offsets in a packed segment are 16 bits, at least one full record fits
+    if (_segBytes > 0xFFFF) { _segBytes = 0xFFFF; }
+    if (_segBytes < (sizeof(ESPSL_fileHeader) + _recLength)) { _segBytes = (sizeof(ESPSL_fileHeader) + _recLength); }
+    segData   = (_segBytes - sizeof(ESPSL_fileHeader));
+    _segLines = (segData / sizeof(ESPSL_recHeader));
+    _numSegs  = ((((uint32_t)depth * _recLength) + segData -1) / segData) +1;
+    if (_numSegs > _MAXSEGMENTS) { _numSegs = _MAXSEGMENTS; }
+  }
+  else
+  {
+    _segLines  = ((int32_t)_segBytes - (int32_t)sizeof(ESPSL_fileHeader)) / _recLength;
+    if (_segLines < 1) { _segLines = 1; }
+    _numSegs   = ((depth + _segLines -1) / _segLines) +1;
+    if (_numSegs > _MAXSEGMENTS)
+    {
+      _segLines = ((depth + _MAXSEGMENTS -2) / (_MAXSEGMENTS -1));
+      _numSegs  = ((depth + _segLines -1) / _segLines) +1;
+    }
+  }
+  _numLines  = (_numSegs * _segLines);
+  _fileFlags = (_HDR_SPARSE | _HDR_SEGMENT | (_segPacked ? _HDR_PACKED : 0));
+  if (_segPacked && !allocPacked()) return false;
+  _store->close(_fd);
+  _store->close(_fd ^ 1);
+  _segOpen[0] = -1;
+  _segOpen[1] = -1;
 #ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::write() -> slot[%d], seek[%d/%04d] [%s]\r\n", __LINE__
-                                                                                , _lastUsedLineID
-                                                                                , seekToLine, offset
-                                                                                , lineBuff);
+  if (_Debug(1)) printf("ESPSL(%d)::beginSegments(): [%d] segments of [%d] lines\r\n", __LINE__, _numSegs, _segLines);
 #endif
-  if (!_sysLog.seek(offset, SeekSet)) 
+
+  for (seg = 0; isValid && (seg < _numSegs); seg++)
+  {
+    if (!_store->open(_fd, segmentName(seg, segName), false)) continue;
+    size = _store->size(_fd);
+    if (   (_store->readAt(_fd, 0, (uint8_t*)&fileHdr, sizeof(fileHdr)) != sizeof(fileHdr))
+        || (memcmp(fileHdr.magic, _FILEMAGIC, sizeof(fileHdr.magic)) != 0)
+        || (fileHdr.version != _FILEVERSION) || !(fileHdr.flags & _HDR_SEGMENT)
+        || ((fileHdr.flags & _HDR_PACKED) != (_fileFlags & _HDR_PACKED))
+        || (fileHdr.lineWidth != _lineWidth) || (fileHdr.numLines != (uint32_t)_numLines)
+        || (size > (int32_t)(_segPacked ? _segBytes : (sizeof(fileHdr) + (_segLines * _recLength)))) )
+    {
+      isValid = false;
+    }
+    if (isValid && _segPacked) { _segFirst[seg] = (fileHdr.lastLineID +1); }
+    if (isValid && ((newestSeg < 0) || (fileHdr.lastLineID > newestID)))
+    {
+      newestSeg  = seg;
+      newestID   = fileHdr.lastLineID;
+      newestSize = size;
+    }
+    _store->close(_fd);
+  }
+  if (!isValid)
+  {
+    printf("ESPSL(%d)::begin(): [%s] is not a segment of [%d] lines of [%d] chars, start with new segments\r\n"
+                                                          , __LINE__, segName, _segLines, _lineWidth);
+    removeSegments();
+    newestSeg = -1;
+  }
+
+  _lastUsedLineID = 0;
+  if (newestSeg < 0)
+  {
+    newestSeg  = 0;
+    newestID   = 0;
+    newestSize = sizeof(ESPSL_fileHeader);
+    if (!openSegment(_fd, 0, (_segPacked ? 1 : 0)))
+    {
+      printf("ESPSL(%d)::begin(): Some error creating [%s] .. bailing out!\r\n", __LINE__, segmentName(0, segName));
+      return false;
+    }
+  }
+  else if (!openSegment(_fd, newestSeg, -1))
   {
-    printf("ESPSL(%d)::write(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, seekToLine
-                                                                                , offset
-                                                                                , _sysLog.position());
-    //_sysLog.close();
+    printf("ESPSL(%d)::begin(): Some error opening [%s] .. bailing out!\r\n", __LINE__, segmentName(newestSeg, segName));
     return false;
   }
-  bytesWritten = _sysLog.println(globalBuff) -1; // don't count '\n'
-  _sysLog.flush();
-  //_sysLog.close();
+  //-- the line before the last slot in the newest segment (that one can be
+  //-- torn), init() checks it and finds the last line from there
+  _cursorLineID = newestID;
+  if (_segPacked)
+  {
+    //-- scanPacked() stopped at the first record that is not valid
+    _cursorLineID = (_segFirst[newestSeg] + _pkCount[_fd] -1);
+  }
+  else if (newestSize > (int32_t)sizeof(ESPSL_fileHeader))
+  {
+    //-- in the first round segment 0 starts with (unused) slot 0
+    _cursorLineID = (((newestSeg == 0) && (newestID == 0)) ? 0 : (newestID +1));
+    _cursorLineID += ((newestSize - sizeof(ESPSL_fileHeader) + _recLength -1) / _recLength) -2;
+    if (_cursorLineID < (int32_t)newestID) { _cursorLineID = newestID; }
+  }
+
+  init();
+
+  return true;
+
+} // beginSegments()
+
+//-------------------------------------------------------------------------------------
+const char *ESPSL::segmentName(int32_t seg, char *segName)
+{
+  snprintf(segName, _SEGNAMELEN, _SEGFILE, (int)seg);
+  return segName;
+
+} // segmentName()
 
-  if (bytesWritten != _recLength) 
+//-------------------------------------------------------------------------------------
+//-- open segment seg on fd. firstID >= 0: start it again from line firstID
+//-- with only its header, the lines of the previous round in it are gone
+boolean ESPSL::openSegment(uint8_t fd, int32_t seg, int32_t firstID)
+{
+  ESPSL_fileHeader fileHdr;
+  char             segName[_SEGNAMELEN];
+  boolean          create = (firstID >= 0);
+
+  if (!create && (_segOpen[fd] == seg)) return true;
+  _store->close(fd);
+  _segOpen[fd] = -1;
+  if (create && (_segOpen[fd ^ 1] == seg))
   {
-      printf("ESPSL(%d)::write(): ERROR!! written [%d] bytes but should have been [%d]\r\n"
-                                       , __LINE__, bytesWritten, _recLength);
+    _store->close(fd ^ 1);
+    _segOpen[fd ^ 1] = -1;
+  }
+  if (!_store->open(fd, segmentName(seg, segName), create)) return false;
+  if (create)
+  {
+    memset(&fileHdr, 0, sizeof(fileHdr));
+    memcpy(fileHdr.magic, _FILEMAGIC, sizeof(fileHdr.magic));
+    fileHdr.version    = _FILEVERSION;
+    fileHdr.flags      = _fileFlags;
+    fileHdr.lineWidth  = _lineWidth;
+    fileHdr.numLines   = _numLines;
+    fileHdr.lastLineID = (firstID > 0 ? (firstID -1) : 0);
+    if (_store->writeAt(fd, 0, (uint8_t*)&fileHdr, sizeof(fileHdr)) != sizeof(fileHdr))
+    {
+      printf("ESPSL(%d)::openSegment(): could not write the header of [%s]\r\n", __LINE__, segName);
+      _store->close(fd);
       return false;
+    }
+#ifdef _DODEBUG
+    if (_Debug(3)) printf("ESPSL(%d)::openSegment(): new [%s] from lineID [%d]\r\n", __LINE__, segName, firstID);
+#endif
+  }
+  _segOpen[fd] = seg;
+  if (_segPacked)
+  {
+    if (create)
+    {
+      _segFirst[seg] = (firstID > 0 ? firstID : 1);
+      _pkCount[fd]   = 0;
+      if (fd == _fd) { _pkEnd = sizeof(ESPSL_fileHeader); }
+      if (_pkWalkSeg == seg) { _pkWalkSeg = -1; }
+      _pkRecID = 0;
+    }
+    else scanPacked(fd, seg);
   }
+  return true;
 
-  _oldestLineID = _lastUsedLineID +1; //-- 1 after last
-  nextFree = (_lastUsedLineID % _numLines) + 1;  //-- always skip rec "0"
+} // openSegment()
+
+//-------------------------------------------------------------------------------------
+//-- read or write len bytes at _filePos (slotOffset()) in the segment files.
+//-- Writes are appended to the segment of the newest line (on _fd), a write
+//-- at the first slot of a segment starts it again. A read that ends in a
+//-- short segment is short, slots before that which are not in a segment file
+//-- are read as empty slots (zero's). Returns the bytes done.
+int32_t ESPSL::segmentIO(uint8_t *data, size_t len, boolean doWrite)
+{
+  uint8_t   zeros[64];
+  uint32_t  segData = (_segLines * _recLength);
+  uint32_t  pos, local, piece;
+  uint32_t  done = 0;
+  int32_t   seg, size, bytes, firstID;
+  uint8_t   fd;
+
+  if (_segPacked) return packedIO(data, len, doWrite);
+
+  while (done < len)
+  {
+    if (_filePos < sizeof(ESPSL_fileHeader)) break;
+    pos   = (_filePos - sizeof(ESPSL_fileHeader));
+    seg   = (pos / segData);
+    if (seg >= _numSegs) break;
+    local = sizeof(ESPSL_fileHeader) + (pos % segData);
+    piece = (segData - (pos % segData));
+    if (piece > (len - done)) { piece = (len - done); }
+
+    if (doWrite)
+    {
+      //-- the lineID for the first slot of the segment in this round
+      firstID = (_lastUsedLineID +1) - (((((_lastUsedLineID +1) - (seg * _segLines)) % _numLines) + _numLines) % _numLines);
+      if (firstID < 0) { firstID = 0; }
+      if (local == sizeof(ESPSL_fileHeader))
+      {
+        if (!openSegment(_fd, seg, firstID)) break;
+      }
+      else if (!openSegment(_fd, seg, -1) && !openSegment(_fd, seg, firstID)) break;
+      //-- a record only takes its header and text, fill up the rest of the slot before
+      size = _store->size(_fd);
+      memset(zeros, 0, sizeof(zeros));
+      while ((size >= 0) && ((uint32_t)size < local))
+      {
+        bytes = ((local - size) < sizeof(zeros) ? (local - size) : sizeof(zeros));
+        if (_store->writeAt(_fd, size, zeros, bytes) != (size_t)bytes) break;
+        size += bytes;
+      }
+      bytes = _store->writeAt(_fd, local, &data[done], piece);
+      if (bytes < (int32_t)piece)
+      {
+        if (bytes > 0) { done += bytes; _filePos += bytes; }
+        break;
+      }
+    }
+    else
+    {
+      fd    = ((_segOpen[_fd] == seg) ? _fd : (_fd ^ 1));
+      bytes = (openSegment(fd, seg, -1) ? _store->readAt(fd, local, &data[done], piece) : 0);
+      if (bytes < 0) { bytes = 0; }
+      //-- short at the end like a file, a segment that is short before the end reads empty
+      if ((bytes < (int32_t)piece) && ((done + piece) >= len))
+      {
+        done     += bytes;
+        _filePos += bytes;
+        break;
+      }
+      if (bytes < (int32_t)piece) { memset(&data[done + bytes], 0, (piece - bytes)); }
+    }
+    done     += piece;
+    _filePos += piece;
+  }
+  return done;
+
+} // segmentIO()
+
+//-------------------------------------------------------------------------------------
+void ESPSL::removeSegments()
+{
+  char segName[_SEGNAMELEN];
+
+  _store->close(_fd);
+  _store->close(_fd ^ 1);
+  _segOpen[0] = -1;
+  _segOpen[1] = -1;
+  for (int32_t seg = 0; seg < _MAXSEGMENTS; seg++)
+  {
+    if (!_store->exists(segmentName(seg, segName))) break;
+    _store->remove(segName);
+  }
+  if (_segFirst != NULL) { memset(_segFirst, 0, (_numSegs * sizeof(int32_t))); }
+  _pkCount[0] = 0;
+  _pkCount[1] = 0;
+  _pkRecID    = 0;
+  _pkWalkSeg  = -1;
+
+} // removeSegments()
+
+
+//-------------------------------------------------------------------------------------
+//-- expected size of the sysLog file
+int32_t ESPSL::fileSize()
+{ 
+  return (sizeof(ESPSL_fileHeader) + (_numLines * _recLength));
+
+} // fileSize()
+
+
+//-------------------------------------------------------------------------------------
+//-- CRC-16/CCITT (polynomial 0x1021), 4 bits at a time
+static uint16_t crc16(uint16_t crc, const uint8_t *data, int32_t len)
+{
+  static const uint16_t nibble[16] = { 0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7
+                                     , 0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef };
+  for (int32_t i = 0; i < len; i++)
+  {
+    crc = (crc << 4) ^ nibble[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+
+} // crc16()
+
+//-------------------------------------------------------------------------------------
+//-- CRC of the header (with crc = 0) and the text of a record
+static uint16_t recordCRC(const uint8_t *rec)
+{
+  ESPSL_recHeader recHdr;
+
+  memcpy(&recHdr, rec, sizeof(ESPSL_recHeader));
+  recHdr.crc = 0;
+  return crc16(crc16(0xFFFF, (uint8_t*)&recHdr, sizeof(ESPSL_recHeader))
+                                    , &rec[sizeof(ESPSL_recHeader)], recHdr.len);
+
+} // recordCRC()
 
+
+//-------------------------------------------------------------------------------------
+//-- packed segments (setSegments(.., true)): the records of a segment are
+//-- appended one after the other with only their header and text. The rest
+//-- of ESPSL still sees slots of _recLength, packedIO() maps a slot to its
+//-- lineID and finds that record with a small index of the open segments.
+boolean ESPSL::allocPacked()
+{
+  freePacked();
+  _segFirst   = (int32_t*)calloc(_numSegs, sizeof(int32_t));
+  _pkIndex[0] = (uint16_t*)malloc(((_segLines / _IDXEVERY) +1) * sizeof(uint16_t));
+  _pkIndex[1] = (uint16_t*)malloc(((_segLines / _IDXEVERY) +1) * sizeof(uint16_t));
+  _pkRec      = (uint8_t*)malloc(_recLength +1);
+  if ((_segFirst == NULL) || (_pkIndex[0] == NULL) || (_pkIndex[1] == NULL) || (_pkRec == NULL))
+  {
+    printf("ESPSL(%d)::allocPacked(): could not allocate the index of [%d] segments\r\n", __LINE__, _numSegs);
+    freePacked();
+    return false;
+  }
   return true;
 
-} // write()
+} // allocPacked()
 
+//-------------------------------------------------------------------------------------
+void ESPSL::freePacked()
+{
+  free(_segFirst);
+  free(_pkIndex[0]);
+  free(_pkIndex[1]);
+  free(_pkRec);
+  _segFirst   = NULL;
+  _pkIndex[0] = NULL;
+  _pkIndex[1] = NULL;
+  _pkRec      = NULL;
+  _pkCount[0] = 0;
+  _pkCount[1] = 0;
+  _pkRecID    = 0;
+  _pkWalkSeg  = -1;
+
+} // freePacked()
 
 //-------------------------------------------------------------------------------------
-boolean ESPSL::writef(const char *fmt, ...) 
+//-- index the records in segment seg (open on fd), up to the first one that
+//-- is torn or not the next lineID
+void ESPSL::scanPacked(uint8_t fd, int32_t seg)
 {
-  char lineBuff[(_MAXLINEWIDTH + 101)];
-  memset(lineBuff, 0, (_MAXLINEWIDTH + 101));
+  ESPSL_recHeader *recHdr = (ESPSL_recHeader*)_pkRec;
+  uint32_t         offset = sizeof(ESPSL_fileHeader);
+  int32_t          bytesRead, count = 0;
 
+  _pkRecID = 0;
+  while ((offset + sizeof(ESPSL_recHeader)) <= _segBytes)
+  {
+    bytesRead = _store->readAt(fd, offset, _pkRec, _recLength);
+    if (   (bytesRead < (int32_t)sizeof(ESPSL_recHeader))
+        || (recHdr->lineID != (uint32_t)(_segFirst[seg] + count)) || (recHdr->len > _lineWidth)
+        || (bytesRead < (int32_t)(sizeof(ESPSL_recHeader) + recHdr->len))
+        || ((recHdr->flags & _FLAG_CRC) && (recHdr->crc != recordCRC(_pkRec))) ) break;
+    if ((count % _IDXEVERY) == 0) { _pkIndex[fd][count / _IDXEVERY] = offset; }
+    offset += (sizeof(ESPSL_recHeader) + recHdr->len);
+    count++;
+  }
+  _pkCount[fd] = count;
+  if (fd == _fd) { _pkEnd = offset; }
 #ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d)::writef(%s)..\r\n", __LINE__, fmt);
+  if (_Debug(3)) printf("ESPSL(%d)::scanPacked(): segment [%d] has [%d] lines from [%d]\r\n", __LINE__, seg, count, _segFirst[seg]);
 #endif
 
-  va_list args;
-  va_start (args, fmt);
-  vsnprintf (lineBuff, (_MAXLINEWIDTH +100), fmt, args);
-  va_end (args);
+} // scanPacked()
 
-  //-- remove control chars
-  for(int i=0; ((i<strlen(lineBuff)) && (lineBuff[i]!=0)); i++)
+//-------------------------------------------------------------------------------------
+//-- the segment that holds lineID (-1: none). Reads go in lineID order, so
+//-- mostly it is the segment of the previous read
+int32_t ESPSL::packedSegment(int32_t lineID)
+{
+  int32_t seg, next, found = -1;
+
+  if (lineID < 1) return -1;
+  seg = _pkWalkSeg;
+  if ((seg >= 0) && (_segFirst[seg] > 0) && (_segFirst[seg] <= lineID))
+  {
+    next = ((seg +1) % _numSegs);
+    if ((_segFirst[next] <= _segFirst[seg]) || (lineID < _segFirst[next])) return seg;
+  }
+  for (seg = 0; seg < _numSegs; seg++)
   {
-    if ((lineBuff[i] < ' ') || (lineBuff[i] > '~')) { lineBuff[i] = '^'; }
+    if ((_segFirst[seg] > 0) && (_segFirst[seg] <= lineID)
+        && ((found < 0) || (_segFirst[seg] > _segFirst[found]))) { found = seg; }
   }
+  return found;
+
+} // packedSegment()
 
-  bool retVal = write(lineBuff);
+//-------------------------------------------------------------------------------------
+//-- read the record of lineID into _pkRec, false if it is not in a segment
+boolean ESPSL::readPacked(int32_t lineID)
+{
+  ESPSL_recHeader  recHdr;
+  ESPSL_recHeader *pkHdr = (ESPSL_recHeader*)_pkRec;
+  int32_t          seg, num, id, bytesRead;
+  uint32_t         offset;
+  uint8_t          fd;
+
+  if ((lineID > 0) && (lineID == _pkRecID)) return true;
+  seg = packedSegment(lineID);
+  if (seg < 0) return false;
+  fd = ((_segOpen[_fd] == seg) ? _fd : (_fd ^ 1));
+  if (!openSegment(fd, seg, -1)) return false;
+  num = (lineID - _segFirst[seg]);
+  if (num >= _pkCount[fd]) return false;
+
+  if ((_pkWalkSeg == seg) && (_pkWalkID == lineID))
+  {
+    offset = _pkWalkOff;
+  }
+  else
+  {
+    //-- from the index entry before it, at most _IDXEVERY -1 headers
+    offset = _pkIndex[fd][num / _IDXEVERY];
+    for (id = (lineID - (num % _IDXEVERY)); id < lineID; id++)
+    {
+      if (_store->readAt(fd, offset, (uint8_t*)&recHdr, sizeof(recHdr)) != sizeof(recHdr)) return false;
+      offset += (sizeof(ESPSL_recHeader) + recHdr.len);
+    }
+  }
+  _pkRecID  = 0;
+  bytesRead = _store->readAt(fd, offset, _pkRec, _recLength);
+  if (   (bytesRead < (int32_t)sizeof(ESPSL_recHeader)) || (pkHdr->lineID != (uint32_t)lineID)
+      || (pkHdr->len > _lineWidth) || (bytesRead < (int32_t)(sizeof(ESPSL_recHeader) + pkHdr->len)) ) return false;
+  memset(&_pkRec[sizeof(ESPSL_recHeader) + pkHdr->len], 0, (_recLength - sizeof(ESPSL_recHeader) - pkHdr->len));
+  _pkRecID   = lineID;
+  _pkWalkSeg = seg;
+  _pkWalkID  = (lineID +1);
+  _pkWalkOff = (offset + sizeof(ESPSL_recHeader) + pkHdr->len);
+  return true;
+
+} // readPacked()
+
+//-------------------------------------------------------------------------------------
+//-- append record rec to the segment on _fd, the next segment is started
+//-- when it does not fit. Returns the bytes written (0: error)
+size_t ESPSL::appendPacked(const uint8_t *rec)
+{
+  ESPSL_recHeader recHdr;
+  uint32_t        recBytes;
+  int32_t         seg;
+
+  memcpy(&recHdr, rec, sizeof(recHdr));
+  if (recHdr.len > _lineWidth) return 0;
+  recBytes = (sizeof(ESPSL_recHeader) + recHdr.len);
+  if ((_segOpen[_fd] < 0) || ((_pkEnd + recBytes) > _segBytes))
+  {
+    seg = ((_segOpen[_fd] +1) % _numSegs);
+    if (!openSegment(_fd, seg, recHdr.lineID)) return 0;
+  }
+  seg = _segOpen[_fd];
+  if ((int32_t)recHdr.lineID != (_segFirst[seg] + _pkCount[_fd]))
+  {
+    printf("ESPSL(%d)::appendPacked(): lineID [%d] is not the next line [%d]\r\n", __LINE__
+                                          , recHdr.lineID, (_segFirst[seg] + _pkCount[_fd]));
+    return 0;
+  }
+  if (_store->writeAt(_fd, _pkEnd, rec, recBytes) != recBytes) return 0;
+  if ((_pkCount[_fd] % _IDXEVERY) == 0) { _pkIndex[_fd][_pkCount[_fd] / _IDXEVERY] = _pkEnd; }
+  _pkEnd += recBytes;
+  _pkCount[_fd]++;
+  _STAT(_stats.bytesWritten += recBytes);
+  return recBytes;
+
+} // appendPacked()
+
+//-------------------------------------------------------------------------------------
+//-- segmentIO() for packed segments. A slot is the record of the lineID that
+//-- would be in it, a write is a whole record at the start of its slot. Slots
+//-- of lines that are not (or no longer) in a segment read as empty slots.
+int32_t ESPSL::packedIO(uint8_t *data, size_t len, boolean doWrite)
+{
+  uint32_t  pos, inSlot, piece;
+  uint32_t  done = 0;
+  int32_t   slot, lineID, lastID = 0;
+
+  //-- the newest line in the segments, pending lines are not
+  if ((_segOpen[_fd] >= 0) && (_segFirst != NULL)) { lastID = (_segFirst[_segOpen[_fd]] + _pkCount[_fd] -1); }
+
+  while (done < len)
+  {
+    if (_filePos < sizeof(ESPSL_fileHeader)) break;
+    pos    = (_filePos - sizeof(ESPSL_fileHeader));
+    slot   = (pos / _recLength);
+    if (slot >= _numLines) break;
+    inSlot = (pos % _recLength);
+    piece  = (_recLength - inSlot);
+    if (piece > (len - done)) { piece = (len - done); }
+
+    if (doWrite)
+    {
+      if ((inSlot != 0) || (piece < sizeof(ESPSL_recHeader))) break;
+      if (((ESPSL_recHeader*)&data[done])->lineID != 0)    //-- a cleared slot: nothing to append
+      {
+        if (appendPacked(&data[done]) == 0) break;
+        lastID = (_segFirst[_segOpen[_fd]] + _pkCount[_fd] -1);
+      }
+    }
+    else
+    {
+      lineID = (lastID +1) - (((((lastID +1) - slot) % _numLines) + _numLines) % _numLines);
+      if (readPacked(lineID))
+      {
+        memcpy(&data[done], &_pkRec[inSlot], piece);
+      }
+      else
+      {
+        //-- short at the end like a file
+        if ((done + piece) >= len) break;
+        memset(&data[done], 0, piece);
+      }
+    }
+    done     += piece;
+    _filePos += piece;
+  }
+  return done;
+
+} // packedIO()
+
+//-------------------------------------------------------------------------------------
+//-- returns the lineID stored in this slot
+int32_t ESPSL::readSlotID(int32_t slot)
+{
+  uint32_t lineID;
+
+  if (!seekFile(slotOffset(slot)))
+  {
+    printf("ESPSL(%d)::readSlotID(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, slot
+                                                                                    , slotOffset(slot)
+                                                                                    , _filePos);
+    return _EMPTYID;
+  }
+  if (readFile((uint8_t*)&lineID, sizeof(lineID)) != sizeof(lineID)) return _EMPTYID;
+  if ((lineID == 0) || (lineID == _ERASEDID)) return _EMPTYID;
+
+  return (int32_t)lineID;
+
+} // readSlotID()
+
+
+//-------------------------------------------------------------------------------------
+//-- returns the lineID stored in this slot if the record is complete (crc),
+//-- otherwise _EMPTYID. Records without a crc (older files) are complete.
+int32_t ESPSL::readValidID(int32_t slot)
+{
+  uint8_t         *rec    = _workBuff;
+  ESPSL_recHeader *recHdr = (ESPSL_recHeader*)rec;
+
+  if (   !seekFile(slotOffset(slot))
+      || (readFile(rec, sizeof(ESPSL_recHeader)) != sizeof(ESPSL_recHeader))
+      || (recHdr->lineID == 0) || (recHdr->lineID == _ERASEDID) || (recHdr->len > _lineWidth)
+      || (readFile(&rec[sizeof(ESPSL_recHeader)], recHdr->len) != recHdr->len) )
+  {
+    return _EMPTYID;
+  }
+  if ((recHdr->flags & _FLAG_CRC) && (recHdr->crc != recordCRC(rec))) return _EMPTYID;
+
+  return (int32_t)recHdr->lineID;
+
+} // readValidID()
+
+
+//-------------------------------------------------------------------------------------
+//-- mark a slot empty (a torn record after the last complete line)
+void ESPSL::clearSlot(int32_t slot)
+{
+  ESPSL_recHeader recHdr;
+
+  memset(&recHdr, 0, sizeof(ESPSL_recHeader));
+  if (!seekSlot(slot) || (writeFile((const uint8_t*)&recHdr, sizeof(ESPSL_recHeader)) != sizeof(ESPSL_recHeader)))
+  {
+    printf("ESPSL(%d)::clearSlot(): could not clear slot [%d]\r\n", __LINE__, slot);
+  }
+  syncFile();
+
+} // clearSlot()
+
+
+//-------------------------------------------------------------------------------------
+//-- read the record in slot, returns its lineID (or _EMPTYID)
+//-- text must have room for _lineWidth +1 chars
+int32_t ESPSL::readSlot(int32_t slot, ESPSL_recHeader *recHdr, char *text)
+{ 
+  const uint8_t *pending = pendingRecord(slot);
+
+  if (pending != NULL)
+  { 
+    memcpy(recHdr, pending, sizeof(ESPSL_recHeader));
+    memcpy(text, &pending[sizeof(ESPSL_recHeader)], recHdr->len);
+  } 
+  else
+  { 
+    if (!seekFile(slotOffset(slot)))
+    {
+      printf("ESPSL(%d)::readSlot(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, slot
+                                                                                    , slotOffset(slot)
+                                                                                    , _filePos);
+      text[0] = 0;
+      return _EMPTYID;
+    }
+    if (   (readFile((uint8_t*)recHdr, sizeof(ESPSL_recHeader)) != sizeof(ESPSL_recHeader))
+        || (recHdr->len > _lineWidth)
+        || (readFile((uint8_t*)text, recHdr->len) != recHdr->len) )
+    {
+      text[0] = 0;
+      return _EMPTYID;
+    }
+  } 
+  text[recHdr->len] = 0;
+  if ((recHdr->lineID == 0) || (recHdr->lineID == _ERASEDID)) return _EMPTYID;
+  expandText(recHdr, text);
+
+  return (int32_t)recHdr->lineID;
+
+} // readSlot()
+
+
+//-------------------------------------------------------------------------------------
+//-- binary search for the last used lineID
+//-- slot k holds a lineID with (lineID % _numLines) == k. Starting at
+//-- slot 0 the lineID's increase by one up to the last written line, after
+//-- that the slots hold lines of the previous round (or are empty).
+int32_t ESPSL::findLastUsedLineID() 
+{
+  int32_t baseID, lo, hi, mid;
+
+  baseID = readSlotID(0);
+  if (baseID < 0) { baseID = 0; }
+
+  lo = 0;
+  hi = _numLines -1;
+  while (lo < hi)
+  {
+    yield();
+    mid = lo + ((hi - lo +1) / 2);
+    if (readSlotID(mid) == (baseID + mid))
+          lo = mid;
+    else  hi = mid -1;
+  }
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::findLastUsedLineID() => [%d]\r\n", __LINE__, (baseID + lo));
+#endif
+
+  return (baseID + lo);
+
+} // findLastUsedLineID()
+
+
+//-------------------------------------------------------------------------------------
+//-- read and check the file header
+boolean ESPSL::readMetaData()
+{
+  ESPSL_fileHeader fileHdr;
+
+  if (!seekFile(0)) 
+  { 
+    printf("ESPSL(%d)::readMetaData(): seek to position [0] failed (now @%d)\r\n", __LINE__, _filePos);
+    return false;
+  } 
+  if (readFile((uint8_t*)&fileHdr, sizeof(fileHdr)) != sizeof(fileHdr)) return false;
+  if (memcmp(fileHdr.magic, _FILEMAGIC, sizeof(fileHdr.magic)) != 0)       return false;
+  if (fileHdr.version != _FILEVERSION)
+  { 
+    printf("ESPSL(%d)::readMetaData(): unknown version [%d]\r\n", __LINE__, fileHdr.version);
+    return false;
+  } 
+
+  _numLines     = fileHdr.numLines;
+  _lineWidth    = fileHdr.lineWidth;
+  _cursorLineID = fileHdr.lastLineID;
+  _fileFlags    = fileHdr.flags;
+  if (_numLines   < _MINNUMLINES)  { _numLines   = _MINNUMLINES; }
+  if (_lineWidth  < _MINLINEWIDTH) { _lineWidth  = _MINLINEWIDTH; }
+  if (_lineWidth  > _MAXLINEWIDTH) { _lineWidth  = _MAXLINEWIDTH; }
+  _recLength = sizeof(ESPSL_recHeader) + _lineWidth;
+
+  return true;
+
+} // readMetaData()
+
+
+//-------------------------------------------------------------------------------------
+//-- what the open sysLog file is when readMetaData() fails: a binary sysLog file
+//-- of another version, an old text sysLog file ("0000000000|" first) or neither
+uint8_t ESPSL::fileType()
+{
+  char  head[sizeof(ESPSL_fileHeader)];
+  int   i;
+
+  if (!seekFile(0) || (readFile((uint8_t*)head, sizeof(head)) != sizeof(head))) return _FILE_UNKNOWN;
+  if (memcmp(head, _FILEMAGIC, 4) == 0) return _FILE_VERSION;
+  for (i = 0; (i < 10) && (head[i] == '0'); i++) { }
+  if ((i == 10) && (head[10] == '|')) return _FILE_ASCII;
+
+  return _FILE_UNKNOWN;
+
+} // fileType()
+
+
+//-------------------------------------------------------------------------------------
+//-- save the last used lineID in the header so init() does not have to search for it
+boolean ESPSL::writeMetaData() 
+{
+  ESPSL_fileHeader fileHdr;
+  int32_t bytesWritten;
+
+  if (_cursorLineID == _lastUsedLineID) return true;
+  //-- a segment is not written in place, begin() finds the last line from its size
+  if (_segLines > 0)
+  {
+    _cursorLineID = _lastUsedLineID;
+    return true;
+  }
+
+  memset(&fileHdr, 0, sizeof(fileHdr));
+  memcpy(fileHdr.magic, _FILEMAGIC, sizeof(fileHdr.magic));
+  fileHdr.version    = _FILEVERSION;
+  fileHdr.lineWidth  = _lineWidth;
+  fileHdr.numLines   = _numLines;
+  fileHdr.lastLineID = _lastUsedLineID;
+  fileHdr.flags      = _fileFlags;
+
+  if (!seekFile(0)) 
+  {
+    printf("ESPSL(%d)::writeMetaData(): seek to position [0] failed (now @%d)\r\n", __LINE__, _filePos);
+    return false;
+  }
+  bytesWritten = writeFile((const uint8_t*)&fileHdr, sizeof(fileHdr));
+  if (bytesWritten != sizeof(fileHdr))
+  {
+    printf("ESPSL(%d)::writeMetaData(): ERROR!! written [%d] bytes but should have been [%d]\r\n"
+                                     , __LINE__, bytesWritten, sizeof(fileHdr));
+    return false;
+  }
+  _cursorLineID = _lastUsedLineID;
+
+  return true;
+
+} // writeMetaData()
+
+
+//-------------------------------------------------------------------------------------
+//-- convert a sysLog file in the old text layout ("%010d|text   \r\n")
+//-- to the binary layout. Returns false if it is not a text sysLog file.
+boolean ESPSL::migrateAsciiLog()
+{ 
+  const char *tmpFile = "/sysLog.tmp";
+  uint8_t     oldFd   = _fd;
+  int32_t     oldRecLength, recKey, lineID, numLines, lineWidth, maxLineID = 0, bytesRead;
+  char       *text;
+
+  if (!_store->open(oldFd, _sysLogFile, false)) return false;
+
+  //-- record 0: "0000000000|%08d;%d;%d; META DATA .."
+  memset(globalBuff, 0, (_bufWidth +15));  
+  bytesRead = _store->readAt(oldFd, 0, (uint8_t*)globalBuff, (_bufWidth +12));
+  globalBuff[(bytesRead > 0 ? bytesRead : 0)] = 0;
+  if ((text = strchr(globalBuff, '\n')) != NULL) { *text = 0; }
+  text = strchr(globalBuff, '|');
+  if (   (globalBuff[0] != '0') || (text == NULL)
+      || (sscanf(text, "|%d;%d;%d;", &lineID, &numLines, &lineWidth) != 3)
+      || (numLines < _MINNUMLINES) || (lineWidth < _MINLINEWIDTH) || (lineWidth > _MAXLINEWIDTH) )
+  { 
+    _store->close(oldFd);
+    return false;
+  } 
+  printf("ESPSL(%d)::migrateAsciiLog(): convert [%s] (%d lines of %d chars)\r\n", __LINE__, _sysLogFile
+                                                                               , numLines, lineWidth);
+  oldRecLength = lineWidth + 11;    //-- "%010d|" + text
+
+  if (!create(numLines, lineWidth, tmpFile) || !_store->open((oldFd ^ 1), tmpFile, false))
+  { 
+    _store->close(oldFd);
+    return false;
+  } 
+  _fd = (oldFd ^ 1);    //-- writes go to the new file
+
+  for (recKey = 1; recKey <= numLines; recKey++)
+  { 
+    yield();
+    memset(globalBuff, 0, (_bufWidth +15));
+    bytesRead = _store->readAt(oldFd, (recKey * (oldRecLength +1)), (uint8_t*)globalBuff
+                                    , (oldRecLength < (_bufWidth +12) ? oldRecLength : (_bufWidth +12)));
+    if (bytesRead <= 0) break;
+    if ((text = strchr(globalBuff, '\n')) != NULL) { *text = 0; }
+    lineID = atol(globalBuff);
+    text   = strchr(globalBuff, '|');
+    if ((lineID <= 0) || (text == NULL)) continue;
+
+    buildRecord(_recBuff, lineID, rtrim(text +1));
+    ((ESPSL_recHeader*)_recBuff)->timeStamp = 0;   //-- unknown
+    sealRecord(_recBuff);
+    if (   !seekSlot(lineID % _numLines)
+        || (writeFile(_recBuff, _recLength) != (size_t)_recLength) )
+    {
+      printf("ESPSL(%d)::migrateAsciiLog(): ERROR writing record [%d]\r\n", __LINE__, lineID);
+      break;
+    }
+    if (lineID > maxLineID) { maxLineID = lineID; }
+  } 
+  _store->close(oldFd);
+
+  _lastUsedLineID = maxLineID;
+  writeMetaData();
+  _store->close(_fd);
+
+  //-- the new file replaces the text sysLog file
+  return _store->rename(tmpFile, _sysLogFile);
+
+} // migrateAsciiLog()
+
+
+//-------------------------------------------------------------------------------------
+//-- copy the newest lines of the sysLog file (oldest first) to a new file with
+//-- the new geometry, lines are truncated to the new lineWidth. The lineID's
+//-- stay the same. Only one chunk of the old file is in RAM.
+boolean ESPSL::resizeLog(uint16_t depth, uint16_t lineWidth)
+{
+  const char      *tmpFile = "/sysLog.tmp";
+  uint8_t          oldFd   = _fd;
+  ESPSL_recHeader *recHdr;
+  uint8_t         *chunk;
+  const char      *text;
+  int32_t          oldNumLines, oldLineWidth, newLineWidth, oldRecLength, chunkSlots, numSlots, bytesRead;
+  int32_t          fromLineID, toLineID, lineID, i, slot;
+  boolean          isOK = true;
+
+  init();   //-- last used lineID in the old file
+  oldNumLines  = _numLines;
+  oldLineWidth = _lineWidth;
+  oldRecLength = _recLength;
+  toLineID     = _lastUsedLineID;
+  fromLineID   = oldestLineID();
+  if ((toLineID - depth +1) > fromLineID) { fromLineID = (toLineID - depth +1); }
+
+  printf("ESPSL(%d)::resizeLog(): [%d x %d] -> [%d x %d], keep lines [%d..%d]\r\n", __LINE__
+                                                       , oldNumLines, oldLineWidth, depth, lineWidth
+                                                       , fromLineID, toLineID);
+
+  chunkSlots = (_READCHUNK / oldRecLength);
+  if (chunkSlots < 1) { chunkSlots = 1; }
+  chunk = (uint8_t*)malloc(chunkSlots * oldRecLength);
+  if (chunk == NULL)
+  {
+    printf("ESPSL(%d)::resizeLog(): could not allocate [%d] bytes\r\n", __LINE__, (chunkSlots * oldRecLength));
+    return false;
+  }
+
+  //-- from here on _numLines, _lineWidth and _recLength are those of the new file
+  if (!create(depth, lineWidth, tmpFile))
+  {
+    free(chunk);
+    return false;
+  }
+  if (!_store->open((oldFd ^ 1), tmpFile, false))
+  {
+    printf("ESPSL(%d)::resizeLog(): Some error opening [%s]\r\n", __LINE__, tmpFile);
+    free(chunk);
+    return false;
+  }
+  _fd = (oldFd ^ 1);    //-- writes go to the new file
+  newLineWidth = _lineWidth;
+
+  for (lineID = fromLineID; isOK && (lineID <= toLineID); lineID += numSlots)
+  {
+    yield();
+    //-- never read past the last slot of the old file
+    numSlots = (toLineID - lineID +1);
+    if (numSlots > chunkSlots)                                { numSlots = chunkSlots; }
+    if (numSlots > (oldNumLines - (lineID % oldNumLines)))    { numSlots = (oldNumLines - (lineID % oldNumLines)); }
+
+    bytesRead = _store->readAt(oldFd, sizeof(ESPSL_fileHeader) + ((lineID % oldNumLines) * oldRecLength)
+                                    , chunk, (numSlots * oldRecLength));
+    if (bytesRead < 0)
+    {
+      printf("ESPSL(%d)::resizeLog(): read of line [%d] failed\r\n", __LINE__, lineID);
+      isOK = false;
+      break;
+    }
+    if (bytesRead < (numSlots * oldRecLength))
+    {
+      memset(&chunk[bytesRead], 0, ((numSlots * oldRecLength) - bytesRead));
+    }
+
+    for (i = 0; i < numSlots; i++)
+    {
+      //-- the lines are consecutive in the new file as well, only seek at
+      //-- the first line and when the new file wraps to slot 0
+      slot = ((lineID +i) % _numLines);
+      if (((lineID +i) == fromLineID) || (slot == 0))
+      {
+        if (!seekSlot(slot))
+        {
+          printf("ESPSL(%d)::resizeLog(): seek to position [%d/%04d] failed\r\n", __LINE__, slot, slotOffset(slot));
+          isOK = false;
+          break;
+        }
+      }
+      recHdr = (ESPSL_recHeader*)&chunk[i * oldRecLength];
+      text   = (const char*)&chunk[(i * oldRecLength) + sizeof(ESPSL_recHeader)];
+      if ((recHdr->lineID != (uint32_t)(lineID +i)) || (recHdr->len > oldLineWidth))
+      {
+        memset(_recBuff, 0, _recLength);    //-- empty slot
+      }
+      else
+      {
+        if ((oldLineWidth > newLineWidth) && (recHdr->flags & (_FLAG_DEFERRED | _FLAG_LZ)))
+        {
+          //-- truncated raw args or compressed text can not be read anymore and
+          //-- the line can be wider than the new lineWidth, so it is expanded
+          //-- (in globalBuff) with the old lineWidth
+          memcpy(globalBuff, text, recHdr->len);
+          _lineWidth = oldLineWidth;
+          expandText(recHdr, globalBuff);
+          _lineWidth = newLineWidth;
+          recHdr->flags &= ~(_FLAG_DEFERRED | _FLAG_LZ);
+          text = globalBuff;
+        }
+        if (recHdr->len > newLineWidth)
+        {
+          recHdr->len    = newLineWidth;
+          recHdr->flags |= _FLAG_TRUNC;
+        }
+        memset(_recBuff, 0, _recLength);
+        memcpy(_recBuff, recHdr, sizeof(ESPSL_recHeader));
+        memcpy(&_recBuff[sizeof(ESPSL_recHeader)], text, recHdr->len);
+        sealRecord(_recBuff);
+      }
+      if (writeFile(_recBuff, _recLength) != (size_t)_recLength)
+      {
+        printf("ESPSL(%d)::resizeLog(): ERROR writing line [%d]\r\n", __LINE__, (lineID +i));
+        isOK = false;
+        break;
+      }
+    }
+  }
+  free(chunk);
+  _store->close(oldFd);
+
+  _lastUsedLineID = (isOK ? toLineID : 0);
+  writeMetaData();
+  _store->close(_fd);
+
+  if (!isOK)
+  {
+    _store->remove(tmpFile);
+    return false;
+  }
+  //-- the new file replaces the old one, there always is a sysLog file
+  return _store->rename(tmpFile, _sysLogFile);
+
+} // resizeLog()
+
+
+//-------------------------------------------------------------------------------------
+//-- set the crc of a record that is ready to be written
+void ESPSL::sealRecord(uint8_t *rec)
+{
+  if (_lzOn && !(((ESPSL_recHeader*)rec)->flags & (_FLAG_DEFERRED | _FLAG_LZ))) { packText(rec); }
+  ((ESPSL_recHeader*)rec)->flags |= _FLAG_CRC;
+  ((ESPSL_recHeader*)rec)->crc    = recordCRC(rec);
+
+} // sealRecord()
+
+
+//-------------------------------------------------------------------------------------
+//-- fill recOut with a record for lineID, control chars in text are replaced by '^'
+void ESPSL::buildRecord(uint8_t *recOut, int32_t lineID, const char *text)
+{ 
+  ESPSL_recHeader *recHdr  = (ESPSL_recHeader*)recOut;
+  char            *recText = (char*)&recOut[sizeof(ESPSL_recHeader)];
+  int              len;
+
+  for (len = 0; (len < _lineWidth) && (text[len] != 0); len++)
+  { 
+    if ((text[len] < ' ') || (text[len] > '~'))
+          recText[len] = '^';
+    else  recText[len] = text[len];
+  } 
+  recHdr->lineID    = lineID;
+  recHdr->timeStamp = time(NULL);
+  recHdr->len       = len;
+  recHdr->flags     = (text[len] != 0 ? _FLAG_TRUNC : 0);
+  recHdr->crc       = 0;
+
+} // buildRecord()
+
+
+//-------------------------------------------------------------------------------------
+//-- format prefix + fmt straight into the text of recOut, truncate at lineWidth
+//-- and replace control chars by '^' in the same buffer
+void ESPSL::formatRecord(uint8_t *recOut, int32_t lineID, const char *prefix, const char *fmt, va_list args
+                                                                           , int32_t lineWidth) 
+{
+  ESPSL_recHeader *recHdr  = (ESPSL_recHeader*)recOut;
+  char            *recText = (char*)&recOut[sizeof(ESPSL_recHeader)];
+  int              len = 0, fmtLen, i;
+  boolean          truncated = false;
+
+  if (prefix != NULL)
+  {
+    for (len = 0; (len < lineWidth) && (prefix[len] != 0); len++)
+    {
+      recText[len] = prefix[len];
+    }
+    truncated = (prefix[len] != 0);
+  }
+  //-- recOut has room for the '\0' vsnprintf() adds after lineWidth chars
+  fmtLen = vsnprintf(&recText[len], (lineWidth - len +1), fmt, args);
+  if (fmtLen > 0) { len += fmtLen; }
+  if (len > lineWidth) 
+  { 
+    len       = lineWidth; 
+    truncated = true;
+  }
+
+  for (i = 0; i < len; i++)
+  {
+    if ((recText[i] < ' ') || (recText[i] > '~')) { recText[i] = '^'; }
+  }
+  recHdr->lineID    = lineID;
+  recHdr->timeStamp = time(NULL);
+  recHdr->len       = len;
+  recHdr->flags     = (truncated ? _FLAG_TRUNC : 0);
+  recHdr->crc       = 0;
+
+} // formatRecord()
+
+
+//===========================================================================================
+//-- deferred formatting (writeDeferred())
+//-- text of a deferred record: [firmwareTag:2][fmtHash:2][fmt pointer][raw args ...]
+//===========================================================================================
+enum { _ARG_NONE, _ARG_INT, _ARG_LONG, _ARG_LLONG, _ARG_SIZE, _ARG_DOUBLE, _ARG_STR, _ARG_PTR, _ARG_SKIP, _ARG_BAD };
+
+//-- parse one conversion spec (fmt points to the '%'), returns the char after it
+static const char *parseSpec(const char *fmt, uint8_t *argType, uint8_t *numStars)
+{
+  const char *p = fmt +1;
+  uint8_t     len = 0;    //-- 1:h 2:hh 3:l 4:ll 5:z/t 6:j 7:L
+
+  *numStars = 0;
+  if (*p == '%') { *argType = _ARG_NONE; return (p +1); }
+  while ((*p != 0) && (strchr("-+ #0", *p) != NULL)) { p++; }
+  if (*p == '*')      { (*numStars)++; p++; }
+  else while ((*p >= '0') && (*p <= '9')) { p++; }
+  if (*p == '.')
+  {
+    p++;
+    if (*p == '*')    { (*numStars)++; p++; }
+    else while ((*p >= '0') && (*p <= '9')) { p++; }
+  }
+  if      (*p == 'h')                  { len = (p[1] == 'h') ? 2 : 1; p += (len == 2) ? 2 : 1; }
+  else if (*p == 'l')                  { len = (p[1] == 'l') ? 4 : 3; p += (len == 4) ? 2 : 1; }
+  else if ((*p == 'z') || (*p == 't')) { len = 5; p++; }
+  else if (*p == 'j')                  { len = 6; p++; }
+  else if (*p == 'L')                  { len = 7; p++; }
+
+  switch(*p)
+  {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+              if      (len == 3)               *argType = _ARG_LONG;
+              else if ((len == 4) || (len == 6)) *argType = _ARG_LLONG;
+              else if (len == 5)               *argType = _ARG_SIZE;
+              else                             *argType = _ARG_INT;
+              break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+              *argType = (len == 7) ? _ARG_BAD : _ARG_DOUBLE;
+              break;
+    case 's': *argType = _ARG_STR;  break;
+    case 'p': *argType = _ARG_PTR;  break;
+    case 'n': *argType = _ARG_SKIP; break;
+    default:  *argType = _ARG_BAD;  return p;
+  }
+  return (p +1);
+
+} // parseSpec()
+
+//-- FNV-1a
+static uint32_t hash32(const char *data, int len)
+{
+  uint32_t hash = 2166136261UL;
+  for (int i = 0; i < len; i++)
+  {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+
+} // hash32()
+
+//-- FNV-1a folded to 16 bits
+static uint16_t hash16(const char *data, int len)
+{
+  uint32_t hash = hash32(data, len);
+  return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+
+} // hash16()
+
+//-- the read-only data of the firmware (linker symbols), string literals are in it
+#if defined(ESPSL_HOST)
+  extern "C" char __executable_start, edata;    //-- GNU ld: the program up to its data
+  #define _RODATA_START  ((uintptr_t)&__executable_start)
+  #define _RODATA_END    ((uintptr_t)&edata)
+#else
+  extern "C" char _rodata_start, _rodata_end;   //-- ESP8266 and ESP32 linker scripts
+  #define _RODATA_START  ((uintptr_t)&_rodata_start)
+  #define _RODATA_END    ((uintptr_t)&_rodata_end)
+#endif
+
+//-- length of the format string at fmt, -1 if fmt is not a string in the read-only
+//-- data of this firmware (a format pointer of another firmware)
+static int fmtLength(const char *fmt)
+{
+  size_t room, len;
+
+  if (((uintptr_t)fmt < _RODATA_START) || ((uintptr_t)fmt >= _RODATA_END)) return -1;
+  room = (_RODATA_END - (uintptr_t)fmt);
+  len  = strnlen(fmt, room);
+  return (len < room ? (int)len : -1);
+
+} // fmtLength()
+
+//-------------------------------------------------------------------------------------
+//-- identifies the running firmware, format pointers are only valid in the same firmware
+uint16_t ESPSL::firmwareTag()
+{
+  if (_fwTag == 0)
+  {
+    String md5 = ESP.getSketchMD5();
+    _fwTag = hash16(md5.c_str(), md5.length());
+    if (_fwTag == 0) { _fwTag = 1; }
+  }
+  return _fwTag;
+
+} // firmwareTag()
+
+//-------------------------------------------------------------------------------------
+//-- store the fmt pointer and the raw args in recOut, nothing is formatted.
+//-- Args that do not fit in _lineWidth bytes are dropped.
+void ESPSL::deferRecord(uint8_t *recOut, int32_t lineID, const char *fmt, va_list args)
+{
+  ESPSL_recHeader *recHdr  = (ESPSL_recHeader*)recOut;
+  uint8_t         *recText = &recOut[sizeof(ESPSL_recHeader)];
+  const char      *p = fmt;
+  uint8_t          argType, numStars;
+  int              len, n;
+  uint16_t         fmtHash, fwTag = firmwareTag();
+  boolean          full = false;
+
+  len = 2 * sizeof(uint16_t) + sizeof(const char*);
+  memcpy(&recText[4], &fmt, sizeof(const char*));
+
+  #define _PUTARG(type)  { type v = va_arg(args, type);                                             \
+                           if (!full && (len + (int)sizeof(v)) <= _lineWidth)                        \
+                                { memcpy(&recText[len], &v, sizeof(v)); len += sizeof(v); }         \
+                           else { full = true; } }
+  while (*p != 0)
+  {
+    if (*p != '%') { p++; continue; }
+    p = parseSpec(p, &argType, &numStars);
+    if (argType == _ARG_BAD) break;
+    while (numStars-- > 0) _PUTARG(int);
+    switch(argType)
+    {
+      case _ARG_INT:    _PUTARG(int);         break;
+      case _ARG_LONG:   _PUTARG(long);        break;
+      case _ARG_LLONG:  _PUTARG(long long);   break;
+      case _ARG_SIZE:   _PUTARG(size_t);      break;
+      case _ARG_DOUBLE: _PUTARG(double);      break;
+      case _ARG_PTR:    _PUTARG(void*);       break;
+      case _ARG_SKIP:   (void)va_arg(args, void*); break;
+      case _ARG_STR:    {
+                          const char *str = va_arg(args, const char*);
+                          if (str == NULL) { str = "(null)"; }
+                          n = strlen(str);
+                          if (full || (len >= _lineWidth))    { full = true; break; }
+                          if (n > (_lineWidth - len -1))      { n = (_lineWidth - len -1); }
+                          memcpy(&recText[len], str, n);
+                          recText[len + n] = 0;
+                          len += n +1;
+                        }
+                        break;
+    }
+  }
+  #undef _PUTARG
+
+  fmtHash = hash16(fmt, strlen(fmt));
+  memcpy(&recText[0], &fwTag,   sizeof(uint16_t));
+  memcpy(&recText[2], &fmtHash, sizeof(uint16_t));
+
+  recHdr->lineID    = lineID;
+  recHdr->timeStamp = time(NULL);
+  recHdr->len       = len;
+  recHdr->flags     = _FLAG_DEFERRED | (full ? _FLAG_TRUNC : 0);
+  recHdr->crc       = 0;
+
+} // deferRecord()
+
+//-------------------------------------------------------------------------------------
+//-- turn the text of a deferred or compressed record (in text) into the line
+void ESPSL::expandText(ESPSL_recHeader *recHdr, char *text)
+{
+  uint8_t    *raw = _workBuff;
+  char        spec[24];
+  const char *fmt, *p, *specStart;
+  uint16_t    fwTag, fmtHash, lzTag;
+  uint8_t     argType, numStars;
+  int         rawLen, pos, out = 0, stars[2], n, fmtLen;
+
+  if (text == NULL) return;
+
+  if (recHdr->flags & _FLAG_LZ)
+  {
+    //-- unpackText() overwrites text, also when it fails
+    lzTag = (recHdr->len >= 2 ? ((uint8_t)text[0] | ((uint8_t)text[1] << 8)) : 0);
+    if (!unpackText(recHdr, text))
+    {
+      snprintf(text, (_lineWidth +1), "<compressed line [%04x], other dictionary>", lzTag);
+      recHdr->len    = strlen(text);
+      recHdr->flags &= ~_FLAG_LZ;
+    }
+    return;   //-- a deferred record is never compressed
+  }
+  if ((recHdr->flags & _FLAG_DEFERRED) == 0) return;
+
+  rawLen = recHdr->len;
+  memcpy(raw, text, rawLen);
+  raw[rawLen] = 0;    //-- a damaged string arg can not run past the end
+  if (rawLen < (int)(2 * sizeof(uint16_t) + sizeof(const char*)))
+  {
+    snprintf(text, (_lineWidth +1), "<deferred line, no format>");
+    recHdr->len = strlen(text);
+    return;
+  }
+  memcpy(&fwTag,   &raw[0], sizeof(uint16_t));
+  memcpy(&fmtHash, &raw[2], sizeof(uint16_t));
+  memcpy(&fmt,     &raw[4], sizeof(const char*));
+  pos = 2 * sizeof(uint16_t) + sizeof(const char*);
+
+  //-- the format string only exists in the firmware that wrote the line, a pointer
+  //-- of another firmware (the 16 bit tag can match) is not followed outside its data
+  if (   (fwTag != firmwareTag())
+      || ((fmtLen = fmtLength(fmt)) < 0)
+      || (hash16(fmt, fmtLen) != fmtHash) )
+  {
+    snprintf(text, (_lineWidth +1), "<deferred line [%04x] from other firmware>", fmtHash);
+    recHdr->len = strlen(text);
+    return;
+  }
+
+  #define _GETARG(type, v)  type v; if ((pos + (int)sizeof(v)) > rawLen) break;            \
+                                    memcpy(&v, &raw[pos], sizeof(v)); pos += sizeof(v);
+  #define _PUTOUT(v)        if (numStars == 0)      n = snprintf(&text[out], (_lineWidth - out +1), spec, v);                       \
+                            else if (numStars == 1) n = snprintf(&text[out], (_lineWidth - out +1), spec, stars[0], v);             \
+                            else                    n = snprintf(&text[out], (_lineWidth - out +1), spec, stars[0], stars[1], v);
+  p = fmt;
+  while ((*p != 0) && (out < _lineWidth))
+  {
+    if (*p != '%') { text[out++] = *p++; continue; }
+    specStart = p;
+    p = parseSpec(p, &argType, &numStars);
+    if (argType == _ARG_BAD)  break;
+    if (argType == _ARG_NONE) { text[out++] = '%'; continue; }
+    if (argType == _ARG_SKIP) continue;
+    if ((p - specStart) >= (int)sizeof(spec)) break;
+    memcpy(spec, specStart, (p - specStart));
+    spec[p - specStart] = 0;
+    if ((pos + (int)(numStars * sizeof(int))) > rawLen) break;
+    memcpy(stars, &raw[pos], (numStars * sizeof(int)));
+    pos += (numStars * sizeof(int));
+
+    n = 0;
+    if (argType == _ARG_STR)
+    {
+      if (pos >= rawLen) break;
+      const char *str = (const char*)&raw[pos];
+      pos += strlen(str) +1;
+      _PUTOUT(str);
+    }
+    else if (argType == _ARG_INT)    { _GETARG(int, v);       _PUTOUT(v); }
+    else if (argType == _ARG_LONG)   { _GETARG(long, v);      _PUTOUT(v); }
+    else if (argType == _ARG_LLONG)  { _GETARG(long long, v); _PUTOUT(v); }
+    else if (argType == _ARG_SIZE)   { _GETARG(size_t, v);    _PUTOUT(v); }
+    else if (argType == _ARG_DOUBLE) { _GETARG(double, v);    _PUTOUT(v); }
+    else if (argType == _ARG_PTR)    { _GETARG(void*, v);     _PUTOUT(v); }
+    if (n > 0) { out += n; }
+  }
+  #undef _GETARG
+  #undef _PUTOUT
+
+  if (out > _lineWidth) { out = _lineWidth; }
+  for (n = 0; n < out; n++)
+  {
+    if ((text[n] < ' ') || (text[n] > '~')) { text[n] = '^'; }
+  }
+  text[out]   = 0;
+  recHdr->len = out;
+
+} // expandText()
+
+
+//===========================================================================================
+//-- compressed records (setCompression())
+//-- text of a compressed record: [dictionary tag:2][tokens ..], the tag is the 16 bit
+//-- hash of the dictionary (low byte first, shown by "<compressed line [tag], other
+//-- dictionary>" when the line can not be read with this dictionary). A token is
+//--   0x20..0x7E      one char
+//--   0x01 c          char c
+//--   1LLLLOOO OOOOOOOO  copy L+3 chars from O+1 chars back in dictionary + line
+//===========================================================================================
+
+//-- common log text, used when setCompression() gets no dictionary
+static const char lzDefaultDict[] =
+      "connected disconnected reconnect failed error Error ERROR warning timeout "
+      "started stopped done ready OK true false value state status sensor "
+      "temperature humidity pressure voltage WiFi MQTT http://  https:// "
+      "IP address: 192.168. Free heap: bytes size: File: /sysLog.dat "
+      "setup() loop() begin() ] [ ( ) -----[ ]------ [00:00:00][ ";
+
+//-- hash of the 3 chars at text
+static uint8_t lzHash3(const uint8_t *text)
+{
+  return (uint8_t)((text[0] * 33 * 33) + (text[1] * 33) + text[2]);
+
+} // lzHash3()
+
+//-- tag of the built-in dictionary
+static uint16_t lzDefaultTag()
+{
+  static uint16_t tag = 0;
+
+  if (tag == 0) { tag = (hash16(lzDefaultDict, strlen(lzDefaultDict)) | 0x0001); }
+  return tag;
+
+} // lzDefaultTag()
+
+//-------------------------------------------------------------------------------------
+//-- compress the text of rec in place, it stays as it is if that is not shorter.
+//-- The compressed text starts with the tag of the dictionary (2 bytes, low byte
+//-- first). The dictionary is the history before the line, so a line that starts
+//-- like a dictionary entry is a copy from its first char.
+void ESPSL::packText(uint8_t *rec)
+{
+  ESPSL_recHeader *recHdr = (ESPSL_recHeader*)rec;
+  uint8_t         *text   = &rec[sizeof(ESPSL_recHeader)];
+  const uint8_t   *dict   = (const uint8_t*)_lzDict;
+  uint8_t         *out    = _workBuff;
+  uint8_t          lineHash[_LZHASHSIZE];   //-- position +1 in the line
+  int              len = recHdr->len, pos = 0, outLen = 2;
+  int              h = 0, cand, n, best, bestOff = 0;
+
+  if ((_lzHash == NULL) || (len < 8)) return;
+  memset(lineHash, 0, sizeof(lineHash));
+  out[0] = (_lzTag & 0xFF);
+  out[1] = (_lzTag >> 8);
+
+  while (pos < len)
+  {
+    if ((outLen +3) >= len) return;   //-- not shorter
+    best = 0;
+    if ((pos +3) <= len)
+    {
+      h    = lzHash3(&text[pos]);
+      cand = (lineHash[h] -1);
+      if (cand >= 0)
+      {
+        for (n = 0; (n < _LZMAXMATCH) && ((pos + n) < len) && (text[cand + n] == text[pos + n]); n++) ;
+        best    = n;
+        bestOff = (pos - cand);
+      }
+      cand = (_lzHash[h] -1);
+      if ((cand >= 0) && ((_lzDictLen - cand + pos) <= _LZMAXOFFSET))
+      {
+        for (n = 0; (n < _LZMAXMATCH) && ((pos + n) < len) && ((cand + n) < _lzDictLen)
+                                      && (dict[cand + n] == text[pos + n]); n++) ;
+        if (n > best)
+        {
+          best    = n;
+          bestOff = (_lzDictLen - cand + pos);
+        }
+      }
+    }
+    if (best >= 3)
+    {
+      out[outLen++] = (0x80 | ((best -3) << 3) | ((bestOff -1) >> 8));
+      out[outLen++] = ((bestOff -1) & 0xFF);
+      for (n = 0; n < best; n++, pos++)
+      {
+        if ((pos +3) <= len) { lineHash[lzHash3(&text[pos])] = (pos +1); }
+      }
+    }
+    else
+    {
+      if ((text[pos] < ' ') || (text[pos] > '~')) { out[outLen++] = 0x01; }
+      out[outLen++] = text[pos];
+      if ((pos +3) <= len) { lineHash[h] = (pos +1); }
+      pos++;
+    }
+  }
+  memcpy(text, out, outLen);
+  recHdr->len    = outLen;
+  recHdr->flags |= _FLAG_LZ;
+
+} // packText()
+
+//-------------------------------------------------------------------------------------
+//-- decompress the text of a compressed record (in text), false if it was
+//-- compressed with another dictionary or is damaged
+boolean ESPSL::unpackText(ESPSL_recHeader *recHdr, char *text)
+{
+  uint8_t    *raw     = _workBuff;
+  const char *dict    = _lzDict;
+  int         dictLen = _lzDictLen;
+  int         rawLen  = recHdr->len, pos = 2, out = 0, n, len, src;
+  uint16_t    tag;
+  uint8_t     b;
+
+  if ((rawLen < 2) || (rawLen > _bufWidth)) return false;
+  memcpy(raw, text, rawLen);
+  tag = (raw[0] | (raw[1] << 8));
+  if ((_lzDict == NULL) || (tag != _lzTag))
+  {
+    //-- compressed with the built-in dictionary (and setCompression() not called)
+    if (tag != lzDefaultTag()) return false;
+    dict    = lzDefaultDict;
+    dictLen = strlen(lzDefaultDict);
+  }
+  while ((pos < rawLen) && (out < _lineWidth))
+  {
+    b = raw[pos++];
+    if (b & 0x80)
+    {
+      if (pos >= rawLen) return false;
+      len = (((b >> 3) & 0x0F) +3);
+      src = ((dictLen + out) - ((((b & 0x07) << 8) | raw[pos++]) +1));
+      if (src < 0) return false;
+      //-- one char at a time, a copy can overlap what it writes
+      for (n = 0; (n < len) && (out < _lineWidth); n++, src++)
+      {
+        text[out++] = (src < dictLen ? dict[src] : text[src - dictLen]);
+      }
+    }
+    else if (b == 0x01)
+    {
+      if (pos >= rawLen) return false;
+      text[out++] = raw[pos++];
+    }
+    else text[out++] = b;
+  }
+  text[out]      = 0;
+  recHdr->len    = out;
+  recHdr->flags &= ~_FLAG_LZ;
+  return true;
+
+} // unpackText()
+
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL::write(const char* logLine) 
+{
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::write(%s)..\r\n", __LINE__, logLine);
+#endif
+
+#ifdef _DODEBUG
+  if (_Debug(4)) printf("ESPSL(%d)::write(): oldest[%8d], last[%8d]\r\n"
+                                                      , __LINE__
+                                                      , _oldestLineID
+                                                      , _lastUsedLineID);
+#endif
+  
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  buildRecord(_recBuff, _lastUsedLineID, logLine);
+
+  return writeRecord();
+
+} // write()
+
+
+//-------------------------------------------------------------------------------------
+//-- seal the record in _recBuff (lineID _lastUsedLineID) and store it, the
+//-- latency is counted from _statStart (set by the write methods)
+boolean ESPSL::writeRecord() 
+{
+  boolean  isOK;
+
+  if (_dupSuppress)
+  {
+    if (isRepeat())
+    {
+      //-- only counted, the lineID is not used
+      _lastUsedLineID--;
+      _STAT(_stats.suppressedLines++);
+      if ((_dupTimeout > 0) && ((millis() - _dupStart) >= _dupTimeout)) { writeRepeats(); }
+      return true;
+    }
+    if (_dupCount > 0)
+    {
+      //-- the summary goes before the new line, that waits in globalBuff
+      //-- (_bufWidth +15 chars, its text is already in _recBuff)
+      memcpy(globalBuff, _recBuff, _recLength);
+      _lastUsedLineID--;
+      writeRepeats();
+      _lastUsedLineID++;
+      memcpy(_recBuff, globalBuff, _recLength);
+      ((ESPSL_recHeader*)_recBuff)->lineID = _lastUsedLineID;
+    }
+  }
+
+  sealRecord(_recBuff);
+  isOK = storeRecord();
+#ifdef _DOSTATS
+  _stats.linesWritten++;
+  if (((ESPSL_recHeader*)_recBuff)->flags & _FLAG_TRUNC) { _stats.truncatedLines++; }
+  addLatency(&_stats.write, _statStart);
+#endif
+
+  return isOK;
+
+} // writeRecord()
+
+
+//-------------------------------------------------------------------------------------
+//-- true if the record in _recBuff has the same text (after _dupSkip chars) and
+//-- level as the previous line, otherwise it becomes the previous line
+boolean ESPSL::isRepeat() 
+{
+  ESPSL_recHeader *recHdr = (ESPSL_recHeader*)_recBuff;
+  const char      *text   = (const char*)&_recBuff[sizeof(ESPSL_recHeader)];
+  uint8_t          skip   = (recHdr->len > _dupSkip ? _dupSkip : recHdr->len);
+  uint32_t         hash   = hash32(&text[skip], (recHdr->len - skip));
+
+  if ((hash == _dupHash) && (recHdr->len == _dupLen) && ((recHdr->flags & _FLAG_LEVEL) == _dupFlags))
+  {
+    if (_dupCount == 0) { _dupStart = millis(); }
+    _dupCount++;
+    return true;
+  }
+  _dupHash  = hash;
+  _dupLen   = recHdr->len;
+  _dupFlags = (recHdr->flags & _FLAG_LEVEL);
+
+  return false;
+
+} // isRepeat()
+
+
+//-------------------------------------------------------------------------------------
+//-- write a "repeated N times" line for the suppressed lines
+boolean ESPSL::writeRepeats() 
+{
+  char    summary[40];
+  boolean isOK;
+
+  if (_dupCount == 0) return true;
+
+  snprintf(summary, sizeof(summary), "last message repeated %u times", _dupCount);
+  _dupCount = 0;
+  _lastUsedLineID++;
+  buildRecord(_recBuff, _lastUsedLineID, summary);
+  ((ESPSL_recHeader*)_recBuff)->flags |= _dupFlags;
+  sealRecord(_recBuff);
+  isOK = storeRecord();
+  _STAT(_stats.linesWritten++);
+
+  return isOK;
+
+} // writeRepeats()
+
+
+//-------------------------------------------------------------------------------------
+//-- store the record in _recBuff in the write-behind buffer or in its slot in
+//-- the sysLog file
+boolean ESPSL::storeRecord() 
+{
+  int32_t   bytesWritten, recBytes;
+  int32_t   slot;
+
+  if (_wbMaxLines > 0)
+  {
+    if (_wbBuff == NULL)
+    {
+      _wbBuff = (uint8_t*)malloc(_wbMaxLines * _recLength);
+    }
+    if (_wbBuff != NULL)
+    {
+      if (_wbCount == 0) { _wbStart = millis(); }
+      //-- still full after a failed commit(): the oldest pending line is lost
+      if (_wbCount >= _wbMaxLines)
+      {
+        _wbCount--;
+        _STAT(_stats.droppedLines++);
+      }
+      memcpy(&_wbBuff[(_lastUsedLineID % _wbMaxLines) * _recLength], _recBuff, _recLength);
+      _wbCount++;
+      _oldestLineID = _lastUsedLineID +1; //-- 1 after last
+
+      if (   (_wbCount >= _wbMaxLines)
+          || (_wbMaxBytes > 0 && (uint32_t)(_wbCount * _recLength) >= _wbMaxBytes)
+          || (_wbMaxAge   > 0 && (millis() - _wbStart) >= _wbMaxAge) )
+      {
+        return commit();
+      }
+      return true;
+    }
+    printf("ESPSL(%d)::storeRecord(): could not allocate write buffer .. write through!\r\n", __LINE__);
+  }
+
+  slot = (_lastUsedLineID % _numLines);
+#ifdef _DODEBUG
+  if (_Debug(4)) printf("ESPSL(%d)::storeRecord() -> lineID[%d], seek[%d/%04d] len[%d]\r\n", __LINE__
+                                                                                , _lastUsedLineID
+                                                                                , slot, slotOffset(slot)
+                                                                                , ((ESPSL_recHeader*)_recBuff)->len);
+#endif
+  if (!seekSlot(slot))
+  {
+    printf("ESPSL(%d)::storeRecord(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, slot
+                                                                                , slotOffset(slot)
+                                                                                , _filePos);
+    return false;
+  }
+  //-- only the header and the text, the rest of the slot is not used
+  recBytes     = sizeof(ESPSL_recHeader) + ((ESPSL_recHeader*)_recBuff)->len;
+  bytesWritten = writeFile(_recBuff, recBytes);
+  //-- update the cursor in the header every _CURSOREVERY lines and once every
+  //-- round through the file, it limits the recovery scan in init()
+  if ((slot == 0) || ((_lastUsedLineID - _cursorLineID) >= _CURSOREVERY)) { writeMetaData(); }
+  if (_flushEveryLine || (_cursorLineID == _lastUsedLineID)) { syncFile(); }
+
+  if (bytesWritten != recBytes)
+  {
+      printf("ESPSL(%d)::storeRecord(): ERROR!! written [%d] bytes but should have been [%d]\r\n"
+                                       , __LINE__, bytesWritten, recBytes);
+      return false;
+  }
+
+  _oldestLineID = _lastUsedLineID +1; //-- 1 after last
+
+  return true;
+
+} // storeRecord()
+
+
+//-------------------------------------------------------------------------------------
+//-- write all lines pending in the write-behind buffer to the sysLog file
+boolean ESPSL::commit() 
+{
+  int32_t   bytesWritten;
+  int32_t   slot;
+  int32_t   lineID;
+
+  if ((_wbBuff == NULL) || (_wbCount == 0)) return true;
+
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::commit() [%d] lines..\r\n", __LINE__, _wbCount);
+#endif
+
+  //-- pending lines are consecutive and written as complete slots, so
+  //-- only seek at the start and when the ring in the file wraps to slot 0
+  for (lineID = (_lastUsedLineID - _wbCount +1); lineID <= _lastUsedLineID; lineID++)
+  {
+    slot = (lineID % _numLines);
+    if ((lineID == (_lastUsedLineID - _wbCount +1)) || (slot == 0))
+    {
+      if (!seekSlot(slot))
+      {
+        printf("ESPSL(%d)::commit(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, slot
+                                                                                     , slotOffset(slot)
+                                                                                     , _filePos);
+        keepPending(lineID);
+        return false;
+      }
+    }
+    bytesWritten = writeFile(&_wbBuff[(lineID % _wbMaxLines) * _recLength], _recLength);
+    if (bytesWritten != _recLength) 
+    {
+      printf("ESPSL(%d)::commit(): ERROR!! written [%d] bytes but should have been [%d]\r\n"
+                                       , __LINE__, bytesWritten, _recLength);
+      keepPending(lineID);
+      return false;
+    }
+  }
+  writeMetaData();
+  syncFile();
+  _wbCount = 0;
+
+  return true;
+
+} // commit()
+
+//-------------------------------------------------------------------------------------
+//-- commit() failed at lineID: the lines from lineID stay pending, the next commit()
+//-- (a full buffer, loop() after maxAgeMs) writes them again from their first slot
+void ESPSL::keepPending(int32_t lineID)
+{
+  _wbCount = (_lastUsedLineID - lineID +1);
+  _wbStart = millis();
+
+} // keepPending()
+
+
+//-------------------------------------------------------------------------------------
+//-- call from loop() to commit pending lines that are older than maxAgeMs
+void ESPSL::loop() 
+{
+  if ((_dupCount > 0) && (_dupTimeout > 0) && ((millis() - _dupStart) >= _dupTimeout))
+  {
+    writeRepeats();
+  }
+  if ((_wbCount > 0) && (_wbMaxAge > 0) && ((millis() - _wbStart) >= _wbMaxAge))
+  {
+    commit();
+  }
+
+} // loop()
+
+
+//-------------------------------------------------------------------------------------
+//-- keep up to maxLines in RAM and write them in one batch (maxLines == 0 -> write through)
+void ESPSL::setBuffered(uint16_t maxLines, uint32_t maxBytes, uint32_t maxAgeMs) 
+{
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::setBuffered(%d, %d, %d)..\r\n", __LINE__, maxLines, maxBytes, maxAgeMs);
+#endif
+  commit();
+  if (_wbBuff != NULL) 
+  { 
+    free(_wbBuff);
+    _wbBuff = NULL;
+  }
+  _wbCount = 0;   //-- what commit() could not write is lost
+  _wbMaxLines = maxLines;
+  _wbMaxBytes = maxBytes;
+  _wbMaxAge   = maxAgeMs;
+
+} // setBuffered()
+
+
+//-------------------------------------------------------------------------------------
+//-- lazy: create() only writes the file header, the sysLog file grows when the
+//-- slots are used. Otherwise (default) create() writes all (empty) slots.
+void ESPSL::setLazyCreate(boolean lazy) 
+{
+  _lazyCreate = lazy;
+
+} // setLazyCreate()
+
+
+//-------------------------------------------------------------------------------------
+//-- suppress a line that is the same as the previous line (ignoring the first
+//-- skipPrefix chars), the repeats are counted and written as one "last message
+//-- repeated N times" line when a different line comes in or after timeoutMs
+//-- (0 is no timeout, needs loop())
+void ESPSL::setSuppressRepeats(boolean suppress, uint8_t skipPrefix, uint32_t timeoutMs) 
+{
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::setSuppressRepeats(%d, %d, %d)..\r\n", __LINE__, suppress, skipPrefix, timeoutMs);
+#endif
+  writeRepeats();
+  _dupSuppress = suppress;
+  _dupSkip     = skipPrefix;
+  _dupTimeout  = timeoutMs;
+  _dupHash     = 0;
+  _dupLen      = 0;
+
+} // setSuppressRepeats()
+
+
+//-------------------------------------------------------------------------------------
+//-- true (default): flush the sysLog file after every line. With false the file is
+//-- flushed with the cursor (every _CURSOREVERY lines), after a reset init() drops
+//-- the lines that did not make it to flash.
+void ESPSL::setFlushEveryLine(boolean flushEveryLine) 
+{
+  _flushEveryLine = flushEveryLine;
+
+} // setFlushEveryLine()
+
+
+//-------------------------------------------------------------------------------------
+//-- returns the record for this slot if it is still in the write-behind buffer
+const uint8_t *ESPSL::pendingRecord(int32_t slot)
+{
+  int32_t lineID;
+
+  if ((_wbBuff == NULL) || (_wbCount == 0)) return NULL;
+
+  //-- lineID that was written last to this slot
+  lineID = _lastUsedLineID - (((_lastUsedLineID % _numLines) - slot + _numLines) % _numLines);
+  if (lineID <= (_lastUsedLineID - _wbCount)) return NULL;
+
+  return &_wbBuff[(lineID % _wbMaxLines) * _recLength];
+
+} // pendingRecord()
+
+
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL::writef(const char *fmt, ...) 
+{
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::writef(%s)..\r\n", __LINE__, fmt);
+#endif
+
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  va_list args;
+  va_start (args, fmt);
+  formatRecord(_recBuff, _lastUsedLineID, NULL, fmt, args, _lineWidth);
+  va_end (args);
+
+  return writeRecord();
+
+} // writef()
+
+
+//-------------------------------------------------------------------------------------
+boolean ESPSL::writeDbg(const char *dbg, const char *fmt, ...) 
+{
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::writeDbg(%s, %s)..\r\n", __LINE__, dbg, fmt);
+#endif
+
+  //-- dbg (normally from buildD()) first, the formatted text fills up the rest
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  va_list args;
+  va_start (args, fmt);
+  formatRecord(_recBuff, _lastUsedLineID, dbg, fmt, args, _lineWidth);
+  va_end (args);
+
+  return writeRecord();
+
+} // writeDbg()
+
+
+//-------------------------------------------------------------------------------------
+//-- like writef() but with a severity, lines above setLogLevel() are not formatted
+boolean ESPSL::writeLvl(uint8_t lvl, const char *fmt, ...) 
+{
+  if (!levelOn(lvl)) return true;
+
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::writeLvl(%d, %s)..\r\n", __LINE__, lvl, fmt);
+#endif
+
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  va_list args;
+  va_start (args, fmt);
+  formatRecord(_recBuff, _lastUsedLineID, NULL, fmt, args, _lineWidth);
+  va_end (args);
+  ((ESPSL_recHeader*)_recBuff)->flags |= (lvl & _FLAG_LEVEL);
+
+  return writeRecord();
+
+} // writeLvl()
+
+
+//-------------------------------------------------------------------------------------
+//-- like writeDbg() but with a severity, lines above setLogLevel() are not formatted
+boolean ESPSL::writeDbgLvl(uint8_t lvl, const char *dbg, const char *fmt, ...) 
+{
+  if (!levelOn(lvl)) return true;
+
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::writeDbgLvl(%d, %s, %s)..\r\n", __LINE__, lvl, dbg, fmt);
+#endif
+
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  va_list args;
+  va_start (args, fmt);
+  formatRecord(_recBuff, _lastUsedLineID, dbg, fmt, args, _lineWidth);
+  va_end (args);
+  ((ESPSL_recHeader*)_recBuff)->flags |= (lvl & _FLAG_LEVEL);
+
+  return writeRecord();
+
+} // writeDbgLvl()
+
+
+//-------------------------------------------------------------------------------------
+//-- like writef() but only the fmt pointer and the raw args are stored, the
+//-- line is formatted when it is read back (by the same firmware)
+boolean ESPSL::writeDeferred(const char *fmt, ...) 
+{
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::writeDeferred(%s)..\r\n", __LINE__, fmt);
+#endif
+
+  _STAT(_statStart = micros());
+  _lastUsedLineID++;
+  va_list args;
+  va_start (args, fmt);
+  deferRecord(_recBuff, _lastUsedLineID, fmt, args);
+  va_end (args);
+
+  return writeRecord();
+
+} // writeDeferred()
+
+
+//-------------------------------------------------------------------------------------
+char *ESPSL::buildD(const char *fmt, ...) 
+{
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::buildD(%s)..\r\n", __LINE__, fmt);
+#endif
+  
+  va_list args;
+  va_start (args, fmt);
+  vsnprintf (globalBuff, (_bufWidth), fmt, args);
+  va_end (args);
+
+  //-- control chars are replaced when the record is formatted
+  return globalBuff;
+  
+} // buildD()
+
+
+
+#if defined(ESP32)
+//-------------------------------------------------------------------------------------
+//-- concurrent mode (ESP32 only)
+//-- writeAsync() can be called from any task on both cores. The line is formatted
+//-- in a cell of a lock-free ring (bounded MPMC queue after D. Vyukov, every cell
+//-- has a sequence number) and one writer task drains the ring to the sysLog file.
+//-- While the writer task runs all other methods have to be called between
+//-- lock() and unlock(), except getStats(), resetStats() and status(). The lock
+//-- is a recursive mutex, so they can take it again.
+//-------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------
+//-- ringSize is rounded up to a power of 2
+boolean ESPSL::startWriter(uint16_t ringSize, uint8_t fullPolicy, UBaseType_t priority, BaseType_t core)
+{
+  TaskHandle_t task;
+  uint32_t     size, i;
+
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::startWriter(%d, %d)..\r\n", __LINE__, ringSize, fullPolicy);
+#endif
+
+  if (_aqRing != NULL) stopWriter();
+
+  for (size = 2; size < ringSize; size <<= 1) { }
+  _aqRing = (ESPSL_asyncCell*)calloc(size, sizeof(ESPSL_asyncCell));
+  if (_aqRing == NULL)
+  {
+    printf("ESPSL(%d)::startWriter(): could not allocate ring of [%d] lines\r\n", __LINE__, size);
+    return false;
+  }
+  for (i = 0; i < size; i++) { _aqRing[i].seq.store(i, std::memory_order_relaxed); }
+  _aqMask   = size -1;
+  _aqPolicy = fullPolicy;
+  _aqHead.store(0);
+  _aqTail.store(0);
+  _aqEnqueued.store(0);
+  _aqDropped.store(0);
+  _aqOverwritten.store(0);
+  _aqWritten.store(0);
+  _aqMicros.store(0);
+  _aqMaxMicros.store(0);
+  _aqWidth.store(_lineWidth);
+
+  _aqLock = xSemaphoreCreateRecursiveMutex();
+  _aqRun  = true;
+  if ((_aqLock == NULL) || (xTaskCreatePinnedToCore(asyncWriter, "ESPSL", 4096, this
+                                                  , priority, &task, core) != pdPASS))
+  {
+    printf("ESPSL(%d)::startWriter(): could not start the writer task\r\n", __LINE__);
+    _aqRun = false;
+    if (_aqLock != NULL) { vSemaphoreDelete(_aqLock); _aqLock = NULL; }
+    free(_aqRing);
+    _aqRing = NULL;
+    return false;
+  }
+  _aqTask = task;
+
+  return true;
+
+} // startWriter()
+
+
+//-------------------------------------------------------------------------------------
+//-- write all lines still in the ring and stop the writer task.
+//-- Call it after the other tasks stopped calling writeAsync().
+void ESPSL::stopWriter()
+{
+  if (_aqRing == NULL) return;
+
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::stopWriter()..\r\n", __LINE__);
+#endif
+
+  //-- the writer task wakes up at least every 100ms
+  _aqRun = false;
+  while (_aqTask != NULL) { vTaskDelay(10); }
+  //-- the writer task released the lock for the last time
+  xSemaphoreTakeRecursive(_aqLock, portMAX_DELAY);
+  vSemaphoreDelete(_aqLock);
+  _aqLock = NULL;
+  free(_aqRing);
+  _aqRing = NULL;
+
+} // stopWriter()
+
+
+//-------------------------------------------------------------------------------------
+void ESPSL::asyncWriter(void *param)
+{
+  ESPSL *self = (ESPSL*)param;
+
+  while (self->_aqRun)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    self->drainAsync();
+  }
+  //-- last round, _aqRun is false so the write-behind buffer is committed
+  self->drainAsync();
+  self->_aqTask = NULL;
+  vTaskDelete(NULL);
+
+} // asyncWriter()
+
+
+//-------------------------------------------------------------------------------------
+//-- write every line in the ring to the sysLog file (writer task only)
+void ESPSL::drainAsync()
+{
+  ESPSL_recHeader *recHdr = (ESPSL_recHeader*)_recBuff;
+
+  if (xSemaphoreTakeRecursive(_aqLock, portMAX_DELAY) != pdTRUE) return;
+
+  //-- lineID's are given in the order the lines were queued. A line queued
+  //-- before a begin() with a smaller lineWidth is cut here
+  while (dequeueAsync(_recBuff))
+  {
+    _STAT(_statStart = micros());
+    _lastUsedLineID++;
+    recHdr->lineID = _lastUsedLineID;
+    if (recHdr->len > _lineWidth)
+    {
+      recHdr->len    = _lineWidth;
+      recHdr->flags |= _FLAG_TRUNC;
+    }
+    writeRecord();
+    _aqWritten.fetch_add(1, std::memory_order_relaxed);
+  }
+  _aqWidth.store(_lineWidth, std::memory_order_relaxed);
+  if (_aqRun) loop();
+  else        commit();
+
+  xSemaphoreGiveRecursive(_aqLock);
+
+} // drainAsync()
+
+
+//-------------------------------------------------------------------------------------
+//-- reserve the next free cell, returns NULL if the ring is full
+ESPSL::ESPSL_asyncCell *ESPSL::claimAsync(uint32_t *pos)
+{
+  ESPSL_asyncCell *cell;
+  uint32_t         p = _aqHead.load(std::memory_order_relaxed);
+  int32_t          diff;
+
+  for(;;)
+  {
+    cell = &_aqRing[p & _aqMask];
+    diff = (int32_t)(cell->seq.load(std::memory_order_acquire) - p);
+    if (diff == 0)
+    {
+      if (_aqHead.compare_exchange_weak(p, p +1, std::memory_order_relaxed)) break;
+    }
+    else if (diff < 0)  return NULL;
+    else                p = _aqHead.load(std::memory_order_relaxed);
+  }
+  *pos = p;
+  return cell;
+
+} // claimAsync()
+
+
+//-------------------------------------------------------------------------------------
+//-- take the oldest line from the ring (copied to recOut if not NULL),
+//-- returns false if the ring is empty or the oldest line is not complete yet
+boolean ESPSL::dequeueAsync(uint8_t *recOut)
+{
+  ESPSL_asyncCell *cell;
+  uint32_t         p = _aqTail.load(std::memory_order_relaxed);
+  int32_t          diff;
+
+  for(;;)
+  {
+    cell = &_aqRing[p & _aqMask];
+    diff = (int32_t)(cell->seq.load(std::memory_order_acquire) - (p +1));
+    if (diff == 0)
+    {
+      if (_aqTail.compare_exchange_weak(p, p +1, std::memory_order_relaxed)) break;
+    }
+    else if (diff < 0)  return false;
+    else                p = _aqTail.load(std::memory_order_relaxed);
+  }
+  if (recOut != NULL)
+  {
+    memcpy(recOut, cell->rec, sizeof(ESPSL_recHeader) + ((ESPSL_recHeader*)cell->rec)->len);
+  }
+  cell->seq.store(p + _aqMask +1, std::memory_order_release);
+
+  return true;
+
+} // dequeueAsync()
+
+
+//-------------------------------------------------------------------------------------
+//-- like writef() but safe to call from any task, the line is formatted in the
+//-- ring and written by the writer task. Returns false if the line was dropped.
+boolean ESPSL::writeAsync(const char *fmt, ...)
+{
+  ESPSL_asyncCell *cell;
+  uint32_t         startMicros = micros();
+  uint32_t         pos, elapsed, maxMicros;
+  int32_t          lineWidth;
+
+  if (_aqRing == NULL) return false;
+
+  while ((cell = claimAsync(&pos)) == NULL)
+  {
+    if (_aqPolicy == ESPSL_Q_OVERWRITE)
+    {
+      if (dequeueAsync(NULL)) _aqOverwritten.fetch_add(1, std::memory_order_relaxed);
+      else                    vTaskDelay(1);
+    }
+    else if (_aqPolicy == ESPSL_Q_BLOCK)
+    {
+      xTaskNotifyGive(_aqTask);
+      vTaskDelay(1);
+    }
+    else
+    {
+      _aqDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  //-- the lineWidth the writer task saw last (a cell holds _MAXLINEWIDTH chars),
+  //-- the lineID is set by the writer task
+  lineWidth = _aqWidth.load(std::memory_order_relaxed);
+  va_list args;
+  va_start (args, fmt);
+  formatRecord(cell->rec, 0, NULL, fmt, args, lineWidth);
+  va_end (args);
+  cell->seq.store(pos +1, std::memory_order_release);
+
+  _aqEnqueued.fetch_add(1, std::memory_order_relaxed);
+  xTaskNotifyGive(_aqTask);
+
+  elapsed   = micros() - startMicros;
+  _aqMicros.fetch_add(elapsed, std::memory_order_relaxed);
+  maxMicros = _aqMaxMicros.load(std::memory_order_relaxed);
+  while ((elapsed > maxMicros) && !_aqMaxMicros.compare_exchange_weak(maxMicros, elapsed)) { }
+
+  return true;
+
+} // writeAsync()
+
+
+//-------------------------------------------------------------------------------------
+void ESPSL::getAsyncStats(ESPSL_asyncStats *stats)
+{
+  stats->enqueued    = _aqEnqueued.load();
+  stats->dropped     = _aqDropped.load();
+  stats->overwritten = _aqOverwritten.load();
+  stats->written     = _aqWritten.load();
+  stats->avgMicros   = (stats->enqueued ? (_aqMicros.load() / stats->enqueued) : 0);
+  stats->maxMicros   = _aqMaxMicros.load();
+
+} // getAsyncStats()
+
+
+//-------------------------------------------------------------------------------------
+//-- keep the writer task away from the sysLog file (for all other methods)
+boolean ESPSL::lock(uint32_t waitMs)
+{
+  if (_aqLock == NULL) return true;
+  return (xSemaphoreTakeRecursive(_aqLock, pdMS_TO_TICKS(waitMs)) == pdTRUE);
+
+} // lock()
+
+
+//-------------------------------------------------------------------------------------
+void ESPSL::unlock()
+{
+  if (_aqLock != NULL) xSemaphoreGiveRecursive(_aqLock);
+
+} // unlock()
+#endif
+
+
+//-------------------------------------------------------------------------------------
+//-- set pointer to startLine
+void ESPSL::startReading() 
+{
+  _readNext         = oldestLineID();
+  _readNextEnd      = _lastUsedLineID +1;
+  _readPrevious     = _lastUsedLineID;
+  _readPreviousEnd  = _readNext -1;
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::startReading()..next[%d] to [%d]\r\n", __LINE__, _readNext, _readNextEnd);
+  if (_Debug(1)) printf("ESPSL(%d)::startReading()..prev[%d] to [%d]\r\n", __LINE__, _readPrevious, _readPreviousEnd);
+#endif
+
+} // startReading()
+
+//-------------------------------------------------------------------------------------
+//-- start reading from _readNext
+bool ESPSL::readNextLine(char *lineOut, int lineOutLen)
+{
+  ESPSL_recHeader recHdr;
+  int32_t         lineID;
+  _STAT(uint32_t  startMicros = micros());
+  
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::readNextLine(%d)\r\n", __LINE__, _readNext);
+#endif
+  
+  if (!_store->isOpen(_fd))
+  {
+    printf("ESPSL(%d)::readNextLine(): _sysLog (%s) not open\r\n", __LINE__, _sysLogFile);
+  }
+  //-- skip empty (or overwritten) slots
+  while (_readNext < _readNextEnd)
+  {
+    lineID = readSlot((_readNext % _numLines), &recHdr, globalBuff);
+#ifdef _DODEBUG
+    if (_Debug(4)) printf("ESPSL(%d)::readNextLine(): [%5d]->recNr[%10d][%10d]-> [%s]\r\n"
+                                                            , __LINE__
+                                                            , (_readNext % _numLines)
+                                                            , _readNext
+                                                            , lineID
+                                                            , globalBuff);
+#endif
+    _readNext++;
+    if (lineID == (_readNext -1))
+    {
+      strlcpy(lineOut, globalBuff, lineOutLen);
+      _STAT(addLatency(&_stats.readNextLine, startMicros));
+      return true;
+    }
+#ifdef _DODEBUG
+    if (_Debug(4)) printf("ESPSL(%d)::readNextLine(): SKIP[%s]\r\n", __LINE__, globalBuff);
+#endif
+  } 
+
+  return false;
+
+} //  readNextLine()
+
+//-------------------------------------------------------------------------------------
+//-- start reading from _readPrevious
+bool ESPSL::readPreviousLine(char *lineOut, int lineOutLen)
+{
+  ESPSL_recHeader recHdr;
+  int32_t         lineID;
+  
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::readPreviousLine(%d/%d)\r\n", __LINE__, _readPrevious, _readPreviousEnd);
+#endif
+  
+  if (!_store->isOpen(_fd))
+  {
+    printf("ESPSL(%d)::readPreviousLine(): _sysLog (%s) not open\r\n", __LINE__, _sysLogFile);
+  }
+  //-- skip empty (or overwritten) slots
+  while (_readPrevious > _readPreviousEnd)
+  {
+    lineID = readSlot((_readPrevious % _numLines), &recHdr, globalBuff);
+#ifdef _DODEBUG
+    if (_Debug(4)) printf("ESPSL(%d)::readPreviousLine(): [%5d]->recNr[%10d][%10d]-> [%s]\r\n"
+                                                            , __LINE__
+                                                            , (_readPrevious % _numLines)
+                                                            , _readPrevious
+                                                            , lineID
+                                                            , globalBuff);
+#endif
+    _readPrevious--;
+    if (lineID == (_readPrevious +1))
+    {
+      strlcpy(lineOut, globalBuff, lineOutLen);
+      return true;
+    }
+#ifdef _DODEBUG
+    if (_Debug(4)) printf("ESPSL(%d)::readPreviousLine(): SKIP[%s]\r\n", __LINE__, globalBuff);
+#endif
+  }
+
+  return false;
+
+} //  readPreviousLine()
+
+//-------------------------------------------------------------------------------------
+//-- oldest lineID that can still be in the sysLog file
+int32_t ESPSL::oldestLineID()
+{
+  int32_t seg;
+
+  //-- packed: the first line of the oldest segment after the one being written
+  if (_segPacked && (_segLines > 0) && (_segFirst != NULL) && (_segOpen[_fd] >= 0))
+  {
+    for (int32_t i = 1; i <= _numSegs; i++)
+    {
+      seg = ((_segOpen[_fd] + i) % _numSegs);
+      if (_segFirst[seg] > 0) return _segFirst[seg];
+    }
+  }
+  if (_lastUsedLineID < _numLines) return 1;
+  return (_lastUsedLineID - _numLines +1);
+
+} // oldestLineID()
+
+//-------------------------------------------------------------------------------------
+//-- read numSlots consecutive slots (not past the last slot) into chunk,
+//-- slots that are not in the file are returned as empty
+int32_t ESPSL::readChunk(int32_t slot, int32_t numSlots, uint8_t *chunk)
+{
+  int32_t bytesRead, i;
+  const uint8_t *pending;
+
+  if (!_store->isOpen(_fd)) return 0;
+
+  //-- after a previous chunk the file is already at the right position
+  if (!seekFile(slotOffset(slot)))
+  {
+    printf("ESPSL(%d)::readChunk(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__, slot
+                                                                                    , slotOffset(slot)
+                                                                                    , _filePos);
+    return 0;
+  }
+  bytesRead = readFile(chunk, (numSlots * _recLength));
+  if (bytesRead < 0) { bytesRead = 0; }
+  if (bytesRead < (numSlots * _recLength))
+  {
+    memset(&chunk[bytesRead], 0, ((numSlots * _recLength) - bytesRead));
+  }
+  //-- lines that are not yet committed
+  for (i = 0; (_wbCount > 0) && (i < numSlots); i++)
+  {
+    pending = pendingRecord(slot +i);
+    if (pending != NULL) { memcpy(&chunk[i * _recLength], pending, _recLength); }
+  }
+
+  return numSlots;
+
+} // readChunk()
+
+//-------------------------------------------------------------------------------------
+//-- pass maxLines (0 is all) lines, starting at fromLineID (0 is oldest), to visitor.
+//-- The file is read in chunks of _READCHUNK bytes, not one seek per line.
+//-- Returns the number of lines passed to visitor.
+int32_t ESPSL::readLines(int32_t fromLineID, int32_t maxLines, ESPSL_lineVisitor visitor, void *ctx)
+{
+  ESPSL_recHeader *recHdr;
+  uint8_t         *chunk;
+  int32_t          lineID, toLineID, chunkSlots, numSlots, i, lineCount = 0;
+
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::readLines(%d, %d)..\r\n", __LINE__, fromLineID, maxLines);
+#endif
+
+  if (fromLineID < oldestLineID()) { fromLineID = oldestLineID(); }
+  toLineID = _lastUsedLineID;
+  if ((maxLines > 0) && ((fromLineID + maxLines -1) < toLineID)) { toLineID = fromLineID + maxLines -1; }
+
+  chunkSlots = (_READCHUNK / _recLength);
+  if (chunkSlots < 1) { chunkSlots = 1; }
+  chunk = (uint8_t*)malloc(chunkSlots * _recLength);
+  if (chunk == NULL)
+  {
+    printf("ESPSL(%d)::readLines(): could not allocate [%d] bytes\r\n", __LINE__, (chunkSlots * _recLength));
+    return 0;
+  }
+
+  for (lineID = fromLineID; lineID <= toLineID; lineID += numSlots)
+  {
+    yield();
+    //-- never read past the last slot, the next chunk starts at slot 0
+    numSlots = (toLineID - lineID +1);
+    if (numSlots > chunkSlots)                          { numSlots = chunkSlots; }
+    if (numSlots > (_numLines - (lineID % _numLines)))  { numSlots = (_numLines - (lineID % _numLines)); }
+
+    if (readChunk((lineID % _numLines), numSlots, chunk) != numSlots) break;
+
+    for (i = 0; i < numSlots; i++)
+    {
+      recHdr = (ESPSL_recHeader*)&chunk[i * _recLength];
+      if ((recHdr->lineID != (uint32_t)(lineID +i)) || (recHdr->len > _lineWidth)) continue;
+
+      memcpy(globalBuff, &chunk[(i * _recLength) + sizeof(ESPSL_recHeader)], recHdr->len);
+      globalBuff[recHdr->len] = 0;
+      expandText(recHdr, globalBuff);
+      lineCount++;
+      if (!visitor(recHdr->lineID, recHdr->timeStamp, globalBuff, ctx))
+      {
+        free(chunk);
+        return lineCount;
+      }
+    }
+  }
+  free(chunk);
+
+  return lineCount;
+
+} // readLines()
+
+//-------------------------------------------------------------------------------------
+//-- pass the lines after lastSeenID (at most maxLines, 0 is all) to visitor, for
+//-- clients that poll for new lines. Lines the client missed because they are
+//-- overwritten are counted in missedLines. Nothing is read if there are no new lines.
+//-- Returns the number of lines passed to visitor.
+int32_t ESPSL::readSince(int32_t lastSeenID, ESPSL_lineVisitor visitor, void *ctx, int32_t maxLines, uint32_t *missedLines)
+{
+  int32_t fromLineID;
+
+  if (missedLines != NULL) { *missedLines = 0; }
+  if (lastSeenID == _lastUsedLineID) return 0;
+
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::readSince(%d, %d)..\r\n", __LINE__, lastSeenID, maxLines);
+#endif
+
+  //-- lastSeenID is from an other (removed) sysLog file, start at the oldest line
+  if ((lastSeenID > _lastUsedLineID) || (lastSeenID < 0)) { lastSeenID = 0; }
+
+  fromLineID = lastSeenID +1;
+  if (fromLineID < oldestLineID())
+  {
+    if ((missedLines != NULL) && (lastSeenID > 0)) { *missedLines = (oldestLineID() - fromLineID); }
+    fromLineID = oldestLineID();
+  }
+
+  return readLines(fromLineID, maxLines, visitor, ctx);
+
+} // readSince()
+
+//-------------------------------------------------------------------------------------
+//-- timeStamp of lineID, 0 if its slot does not hold lineID (anymore)
+uint32_t ESPSL::readTimeStamp(int32_t lineID)
+{
+  ESPSL_recHeader recHdr;
+  const uint8_t  *pending = pendingRecord(lineID % _numLines);
+
+  if (pending != NULL)
+  {
+    memcpy(&recHdr, pending, sizeof(ESPSL_recHeader));
+  }
+  else
+  {
+    if (   !seekFile(slotOffset(lineID % _numLines))
+        || (readFile((uint8_t*)&recHdr, sizeof(ESPSL_recHeader)) != sizeof(ESPSL_recHeader)) )
+    {
+      return 0;
+    }
+  }
+  if (recHdr.lineID != (uint32_t)lineID) return 0;
+
+  return recHdr.timeStamp;
+
+} // readTimeStamp()
+
+//-------------------------------------------------------------------------------------
+//-- binary search for the first lineID with a timeStamp >= t (_EMPTYID if there is none)
+//-- lines are appended so their timeStamps go up, only one header is read per step
+int32_t ESPSL::findTime(uint32_t t)
+{
+  int32_t lo, hi, mid;
+
+  lo = oldestLineID();
+  hi = _lastUsedLineID +1;
+  while (lo < hi)
+  {
+    mid = lo + ((hi - lo) / 2);
+    if (readTimeStamp(mid) < t)
+          lo = mid +1;
+    else  hi = mid;
+  }
+#ifdef _DODEBUG
+  if (_Debug(3)) printf("ESPSL(%d)::findTime(%u) => [%d]\r\n", __LINE__, t, lo);
+#endif
+
+  if (lo > _lastUsedLineID) return _EMPTYID;
+  return lo;
+
+} // findTime()
+
+//-------------------------------------------------------------------------------------
+//-- readNextLine() continues at the first line written at or after t (epoch),
+//-- readPreviousLine() at the line before it. Returns that lineID or _EMPTYID.
+int32_t ESPSL::seekToTime(uint32_t t)
+{
+  int32_t lineID;
+
+#ifdef _DODEBUG
+  if (_Debug(1)) printf("ESPSL(%d)::seekToTime(%u)..\r\n", __LINE__, t);
+#endif
 
-  return retVal;
+  startReading();
+  lineID = findTime(t);
+  if (lineID == _EMPTYID)
+        _readNext = _readNextEnd;
+  else  _readNext = lineID;
+  _readPrevious = _readNext -1;
 
-} // writef()
+  return lineID;
 
+} // seekToTime()
 
 //-------------------------------------------------------------------------------------
-boolean ESPSL::writeDbg(const char *dbg, const char *fmt, ...) 
+//-- pass every line written from tStart up to and including tEnd (epoch) to visitor.
+//-- Returns the number of lines passed to visitor.
+int32_t ESPSL::readRange(uint32_t tStart, uint32_t tEnd, ESPSL_lineVisitor visitor, void *ctx)
 {
+  int32_t fromLineID, toLineID;
+
 #ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d)::writeDbg(%s, %s)..\r\n", __LINE__, dbg, fmt);
+  if (_Debug(1)) printf("ESPSL(%d)::readRange(%u, %u)..\r\n", __LINE__, tStart, tEnd);
 #endif
 
-  int       nextFree;
-  char dbgStr[(_MAXLINEWIDTH + 101)];
-  memset(dbgStr, 0, (_MAXLINEWIDTH + 101));
-  char totBuf[(_MAXLINEWIDTH + 101)];
-  memset(totBuf, 0, (_MAXLINEWIDTH + 101));
-
-  sprintf(dbgStr, "%s", dbg);
-  //printf("ESPSL(%d)::writeDbg([%s], *fmt)..\r\n", __LINE__, dbgStr);
-  
-  va_list args;
-  va_start (args, fmt);
-  vsnprintf (totBuf, (_MAXLINEWIDTH +100), fmt, args);
-  va_end (args);
-  
-  while ((strlen(totBuf) > 0) && (strlen(dbgStr) + strlen(totBuf)) > (_lineWidth -1)) 
-  {
-    totBuf[strlen(totBuf)-1] = '\0';
-    yield();
-  }
-  if ((strlen(dbgStr) + strlen(totBuf)) < _lineWidth) 
-  {
-    strlcat(dbgStr, totBuf, _lineWidth);
-  }
+  if (tStart > tEnd) return 0;
+  fromLineID = findTime(tStart);
+  if (fromLineID == _EMPTYID) return 0;
 
-  //-- remove control chars
-  for(int i=0; ((i<strlen(dbgStr)) && (dbgStr[i]!=0)); i++)
+  toLineID = _lastUsedLineID;
+  if (tEnd < UINT32_MAX)
   {
-    if ((dbgStr[i] < ' ') || (dbgStr[i] > '~')) { dbgStr[i] = '^'; }
+    toLineID = findTime(tEnd +1);
+    if (toLineID == _EMPTYID) toLineID = _lastUsedLineID;
+    else                      toLineID--;
   }
-  //printf("ESPSL(%d)::writeDbg(): dbgStr[%s]..\r\n", __LINE__, dbgStr);
-  bool retVal = write(dbgStr);
-  
-  return retVal;
+  if (toLineID < fromLineID) return 0;
 
-} // writeDbg()
+  return readLines(fromLineID, (toLineID - fromLineID +1), visitor, ctx);
 
+} // readRange()
 
 //-------------------------------------------------------------------------------------
-char *ESPSL::buildD(const char *fmt, ...) 
+//-- first occurrence of pattern (patLen > 0) in text[0..len>, memchr() for the first
+//-- char, memcmp() for the rest
+static const char *findInText(const char *text, int32_t len, const char *pattern, int32_t patLen)
 {
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d)::buildD(%s)..\r\n", __LINE__, fmt);
-#endif
-  memset(globalBuff, 0, sizeof(globalBuff));
-  
-  va_list args;
-  va_start (args, fmt);
-  vsnprintf (globalBuff, (_MAXLINEWIDTH), fmt, args);
-  va_end (args);
+  const char *p   = text;
+  const char *end = text + len - patLen;   //-- last possible start
 
-  //-- remove control chars
-  for(int i=0; ((i<strlen(globalBuff)) && (globalBuff[i]!=0)); i++)
+  while (p <= end)
   {
-    if ((globalBuff[i] < ' ') || (globalBuff[i] > '~')) { globalBuff[i] = '^'; }
+    p = (const char*)memchr(p, pattern[0], (end - p) +1);
+    if (p == NULL) return NULL;
+    if (memcmp(p +1, pattern +1, patLen -1) == 0) return p;
+    p++;
   }
+  return NULL;
 
-  return globalBuff;
-  
-} // buildD()
-
+} // findInText()
 
 //-------------------------------------------------------------------------------------
-//-- set pointer to startLine
-void ESPSL::startReading() 
+//-- pass every line that contains pattern to visitor, oldest first (or newest first
+//-- with ESPSL_FIND_BACKWARD) and stop after maxHits (0 is no limit) lines.
+//-- The text is searched in the chunks read from the sysLog file, only matching
+//-- lines are copied. Returns the number of lines passed to visitor.
+int32_t ESPSL::find(const char *pattern, ESPSL_lineVisitor visitor, void *ctx, uint8_t flags, int32_t maxHits)
 {
-  _readNext         = _lastUsedLineID +1;
-  _readNextEnd      = _readNext + _numLines;
-  _readPrevious     = _lastUsedLineID;
-  _readPreviousEnd  = _readPrevious - _numLines;
-  if (_readPreviousEnd < 0) { _readPreviousEnd = 0; }
+  ESPSL_recHeader *recHdr;
+  uint8_t         *chunk;
+  const char      *text;
+  boolean          backward = (flags & ESPSL_FIND_BACKWARD);
+  int32_t          patLen, fromLineID, toLineID, lineID, firstID, chunkSlots, numSlots, i, n;
+  int32_t          hits = 0;
+
 #ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%d)::startReading()..next[%d] to [%d]\r\n", __LINE__, _readNext, _readNextEnd);
-  if (_Debug(1)) printf("ESPSL(%d)::startReading()..prev[%d] to [%d]\r\n", __LINE__, _readPrevious, _readPreviousEnd);
+  if (_Debug(1)) printf("ESPSL(%d)::find(%s, %d, %d)..\r\n", __LINE__, pattern, flags, maxHits);
 #endif
 
-} // startReading()
+  patLen = strlen(pattern);
+  if ((patLen == 0) || (patLen > _lineWidth)) return 0;
 
-//-------------------------------------------------------------------------------------
-//-- start reading from _readNext
-bool ESPSL::readNextLine(char *lineOut, int lineOutLen)
-{
-  uint32_t  offset;
-  int32_t   recKey = _readNext;
-  int32_t   lineID;
-  uint16_t  seekToLine;  
-  char      lineIn[_recLength];
-  
-#ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%d)::readNextLine(%d)\r\n", __LINE__, _readNext);
-#endif
-  memset(globalBuff, 0, (_recLength+10));
-  memset(lineIn, 0, _recLength);
+  fromLineID = oldestLineID();
+  toLineID   = _lastUsedLineID;
+  if (toLineID < fromLineID) return 0;
 
-  if (_readNext >= _readNextEnd) return false;
-  
-  if (!_sysLog)
+  chunkSlots = (_READCHUNK / _recLength);
+  if (chunkSlots < 1) { chunkSlots = 1; }
+  chunk = (uint8_t*)malloc(chunkSlots * _recLength);
+  if (chunk == NULL)
   {
-    printf("ESPSL(%d)::readNextLine(): _sysLog (%s) not open\r\n", __LINE__, _sysLogFile);
+    printf("ESPSL(%d)::find(): could not allocate [%d] bytes\r\n", __LINE__, (chunkSlots * _recLength));
+    return 0;
   }
-  for(int r=0; r<_numLines; r++)
+
+  lineID = (backward ? toLineID : fromLineID);
+  while ((lineID >= fromLineID) && (lineID <= toLineID))
   {
-    seekToLine = ((_readNext +r) % _numLines) +1;
-    offset     = (seekToLine * (_recLength +1));
-    if (!_sysLog.seek(offset, SeekSet)) 
+    yield();
+    //-- a chunk never crosses the end of the file, forward it starts at lineID,
+    //-- backward it ends at lineID
+    if (backward)
     {
-      printf("ESPSL(%d)::readNextLine(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__
-                                                                                         , seekToLine
-                                                                                         , offset
-                                                                                         , _sysLog.position());
-      return true;
+      numSlots = (lineID - fromLineID +1);
+      if (numSlots > ((lineID % _numLines) +1)) { numSlots = ((lineID % _numLines) +1); }
+    }
+    else
+    {
+      numSlots = (toLineID - lineID +1);
+      if (numSlots > (_numLines - (lineID % _numLines))) { numSlots = (_numLines - (lineID % _numLines)); }
     }
+    if (numSlots > chunkSlots) { numSlots = chunkSlots; }
+    firstID = (backward ? (lineID - numSlots +1) : lineID);
 
-    int l = _sysLog.readBytesUntil('\n', globalBuff, _recLength);
-      sscanf(globalBuff,"%u|%[^\0]", &lineID, lineIn);     
+    if (readChunk((firstID % _numLines), numSlots, chunk) != numSlots) break;
 
-#ifdef _DODEBUG
-    if (_Debug(4)) printf("ESPSL(%d)::readNextLine(): [%5d]->recNr[%010d][%10d]-> [%s]\r\n"
-                                                            , __LINE__
-                                                            , seekToLine
-                                                            , _readNext
-                                                            , lineID
-                                                            , lineIn);
-#endif
-    if (lineID > -1) { _readNext += r; break; }
-    
-  } // for ..
-    _readNext++;
-    if (lineID > (int)_EMPTYID) 
-    {
-      strlcpy(lineOut, rtrim(lineIn), lineOutLen);
-      return true;
-#ifdef _DODEBUG
-    } else 
+    for (n = 0; n < numSlots; n++)
     {
-      if (_Debug(4)) printf("ESPSL(%d)::readNextLine(): SKIP[%s]\r\n", __LINE__, lineIn);
-#endif
+      i      = (backward ? (numSlots -1 -n) : n);
+      recHdr = (ESPSL_recHeader*)&chunk[i * _recLength];
+      if ((recHdr->lineID != (uint32_t)(firstID +i)) || (recHdr->len > _lineWidth)) continue;
+
+      text = (const char*)&chunk[(i * _recLength) + sizeof(ESPSL_recHeader)];
+      if (recHdr->flags & (_FLAG_DEFERRED | _FLAG_LZ))
+      {
+        //-- the text only exists after formatting or decompressing
+        memcpy(globalBuff, text, recHdr->len);
+        expandText(recHdr, globalBuff);
+        if (strstr(globalBuff, pattern) == NULL) continue;
+      }
+      else
+      {
+        if (findInText(text, recHdr->len, pattern, patLen) == NULL) continue;
+        memcpy(globalBuff, text, recHdr->len);
+        globalBuff[recHdr->len] = 0;
+      }
+      hits++;
+      if (!visitor(recHdr->lineID, recHdr->timeStamp, globalBuff, ctx) || (hits == maxHits))
+      {
+        free(chunk);
+        return hits;
+      }
     }
+    lineID = (backward ? (firstID -1) : (firstID + numSlots));
+  }
+  free(chunk);
 
-  return false;
+  return hits;
 
-} //  readNextLine()
+} // find()
 
 //-------------------------------------------------------------------------------------
-//-- start reading from _readNext
-bool ESPSL::readPreviousLine(char *lineOut, int lineOutLen)
+//-- start reading from startLine
+bool ESPSL::dumpLogFile() 
 {
-  uint32_t  offset;
-  int32_t   recKey = _readNext;
-  int32_t   lineID;
-  uint16_t  seekToLine;  
-  //File      tmpFile;
-  char      lineIn[_recLength];
-  
 #ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%d)::readPreviousLine(%d/%d)\r\n", __LINE__, _readPrevious, _readPreviousEnd);
+  if (_Debug(1)) printf("ESPSL(%d)::dumpLogFile()..\r\n", __LINE__);
 #endif
-  memset(globalBuff, 0, (_recLength+10));
-  memset(lineIn, 0, _recLength);
 
-  if (_readPrevious <= _readPreviousEnd) return false;
-  
-  if (!_sysLog)
+  ESPSL_recHeader *recHdr;
+  uint8_t         *chunk;
+  int32_t          slot, lineID, chunkSlots, numSlots, i;
+  memset(globalBuff, 0, (_bufWidth +15));
+      
+  if (!_store->isOpen(_fd)) { _store->open(_fd, _sysLogFile, false); }   //-- open for reading and writing
+
+  checkSysLogFileSize("dumpLogFile():", fileSize());
+
+  chunkSlots = (_READCHUNK / _recLength);
+  if (chunkSlots < 1) { chunkSlots = 1; }
+  chunk = (uint8_t*)malloc(chunkSlots * _recLength);
+  if (chunk == NULL)
   {
-    printf("ESPSL(%d)::readPreviousLine(): _sysLog (%s) not open\r\n", __LINE__, _sysLogFile);
+    printf("ESPSL(%d)::dumpLogFile(): could not allocate [%d] bytes\r\n", __LINE__, (chunkSlots * _recLength));
+    return false;
   }
-  for(int r=0; r<_numLines; r++)
+
+  for (slot = 0; slot < _numLines; slot += numSlots)
   {
-    _readPrevious -= r;
-    if (_readPrevious < 0) return false;
-    seekToLine = (_readPrevious % _numLines) +1;
-    offset     = (seekToLine * (_recLength +1));
-    if (!_sysLog.seek(offset, SeekSet)) 
+    numSlots = (_numLines - slot);
+    if (numSlots > chunkSlots) { numSlots = chunkSlots; }
+    if (readChunk(slot, numSlots, chunk) != numSlots)
     {
-      printf("ESPSL(%d)::readPreviousLine(): seek to position [%d/%04d] failed (now @%d)\r\n", __LINE__
-                                                                                         , seekToLine
-                                                                                         , offset
-                                                                                         , _sysLog.position());
-      return true;
+      free(chunk);
+      return false;
     }
 
-    int l = _sysLog.readBytesUntil('\n', globalBuff, _recLength);
-        sscanf(globalBuff,"%u|%[^\0]", &lineID, lineIn);     
-
-#ifdef _DODEBUG
-    if (_Debug(4)) printf("ESPSL(%d)::readPreviousLine(): [%5d]->recNr[%010d][%10d]-> [%s]\r\n"
-                                                            , __LINE__
-                                                            , seekToLine
-                                                            , _readPrevious
-                                                            , lineID
-                                                            , lineIn);
-#endif
-    if (lineID > -1) { break; }
-    
-  } // for ..
-    
-  _readPrevious--;
-  if (lineID > (int)_EMPTYID) 
-  {
-    strlcpy(lineOut, rtrim(lineIn), lineOutLen);
-    return true;
+    for (i = 0; i < numSlots; i++)
+    {
+      recHdr = (ESPSL_recHeader*)&chunk[i * _recLength];
+      lineID = ((recHdr->lineID == 0) || (recHdr->lineID == _ERASEDID)) ? _EMPTYID : (int32_t)recHdr->lineID;
+      if (recHdr->len > _lineWidth) { recHdr->len = 0; }
+      memcpy(globalBuff, &chunk[(i * _recLength) + sizeof(ESPSL_recHeader)], recHdr->len);
+      globalBuff[recHdr->len] = 0;
+      if (lineID != _EMPTYID) { expandText(recHdr, globalBuff); }
 #ifdef _DODEBUG
-  } else 
-  {
-    if (_Debug(4)) printf("ESPSL(%d)::readPreviousLine(): SKIP[%s]\r\n", __LINE__, lineIn);
+      if (_Debug(5)) printf("ESPSL(%d)::dumpLogFile():  >>>>> [%d] -> [%s]\r\n", __LINE__, recHdr->len, globalBuff);
 #endif
-  }
 
-  return false;
+      if (lineID == (_lastUsedLineID)) 
+      {
+              printf("(a)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, (slot +i), slotOffset(slot +i), lineID, globalBuff);
 
-} //  readPreviousLine()
+              println(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
+      }
+      else if (lineID == (_oldestLineID) ) //&& recKey < _numLines)
+              printf("(b)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, (slot +i), slotOffset(slot +i), lineID, globalBuff);
+      else if ((lineID == _EMPTYID) && (_fileFlags & _HDR_PACKED))
+              continue;   //-- a packed sysLog only has slots for lines that are in it
+      else if (lineID == _EMPTYID) 
+              printf("(c)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, (slot +i), slotOffset(slot +i), lineID, globalBuff);
+      else 
+      {
+         printf("(d)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, (slot +i), slotOffset(slot +i), lineID, globalBuff);
+      }
+    }
+  } //-- for ..
+  free(chunk);
+
+  return true;
+
+} // dumpLogFile
 
 //-------------------------------------------------------------------------------------
-//-- start reading from startLine
-bool ESPSL::dumpLogFile() 
+//-- start exporting all lines (oldest first) to exportTo, call exportStep()
+//-- from loop() until exportDone(). Lines written after this call are not exported.
+//-- With throttle a line is only written if exportTo->availableForWrite() has room,
+//-- but every exportStep() writes at least one line (Print::availableForWrite() of a
+//-- Stream that does not know is 0, a buffer can be smaller than a line).
+void ESPSL::beginExport(Stream &exportTo, boolean throttle)
 {
 #ifdef _DODEBUG
-  if (_Debug(1)) printf("ESPSL(%d)::dumpLogFile()..\r\n", __LINE__);
+  if (_Debug(1)) printf("ESPSL(%d)::beginExport()..\r\n", __LINE__);
 #endif
+  _exportStream   = &exportTo;
+  _exportThrottle = throttle;
+  _exportNext     = oldestLineID();
+  _exportEnd      = _lastUsedLineID;
 
-  int32_t   recKey;
-  uint32_t  offset, seekToLine;
-  memset(globalBuff, 0, sizeof(globalBuff));
-      
-  _sysLog  = LittleFS.open(_sysLogFile, "r+");    //-- open for reading and writing
+} // beginExport()
 
-  checkSysLogFileSize("dumpLogFile():", (_numLines + 1) * (_recLength +1));  //-- add '\n'
+//-------------------------------------------------------------------------------------
+//-- export at most maxLines lines or for at most budgetMicros micro seconds
+//-- (0 is no limit). Returns the number of lines exported.
+int32_t ESPSL::exportStep(uint16_t maxLines, uint32_t budgetMicros)
+{
+  ESPSL_recHeader recHdr;
+  uint32_t        startMicros = micros();
+  int32_t         lineID, lineCount = 0;
 
-  for (recKey = 0; recKey < _numLines; recKey++) 
+  while (!exportDone())
   {
-    seekToLine = (recKey % _numLines)+1;
-    offset = (seekToLine * (_recLength +1));
-    if (!_sysLog.seek(offset, SeekSet)) 
+    if ((maxLines > 0)     && (lineCount >= maxLines))                  break;
+    if ((budgetMicros > 0) && ((micros() - startMicros) >= budgetMicros)) break;
+    yield();
+
+    //-- lines that were overwritten while exporting are lost
+    if (_exportNext < oldestLineID()) { _exportNext = oldestLineID(); }
+
+    lineID = readSlot((_exportNext % _numLines), &recHdr, globalBuff);
+    if (lineID != _exportNext)
     {
-      printf("ESPSL(%d)::dumpLogFile(): seek to position [%d] (offset %d) failed (now @%d)\r\n", __LINE__
-                                                                                              , seekToLine
-                                                                                              , offset
-                                                                                              , _sysLog.position());
-      return false;
+      _exportNext++;
+      continue;
     }
-    uint32_t  lineID;
-    int l = _sysLog.readBytesUntil('\n', globalBuff, _recLength);
+    if (   _exportThrottle && (lineCount > 0)
+        && (_exportStream->availableForWrite() < (recHdr.len +2)) ) break;
+
+    _exportStream->print(globalBuff);
+    _exportStream->print("\r\n");
+    _exportNext++;
+    lineCount++;
+  }
 #ifdef _DODEBUG
-    if (_Debug(5)) printf("ESPSL(%d)::dumpLogFile():  >>>>> [%d] -> [%s]\r\n", __LINE__, l, globalBuff);
+  if (_Debug(3)) printf("ESPSL(%d)::exportStep(): [%d] lines, next[%d] end[%d]\r\n", __LINE__
+                                                                                , lineCount
+                                                                                , _exportNext
+                                                                                , _exportEnd);
 #endif
-    sscanf(globalBuff,"%u|%[^\0]", &lineID, globalBuff);
 
-    if (lineID == (_lastUsedLineID)) 
-    {
-            printf("(a)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, seekToLine, offset, lineID, globalBuff);
+  return lineCount;
 
-            println(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
-    }
-    else if (lineID == (_oldestLineID) ) //&& recKey < _numLines)
-            printf("(b)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, seekToLine, offset, lineID, globalBuff);
-    else if (lineID == _EMPTYID) 
-            printf("(c)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, seekToLine, offset, lineID, globalBuff);
-    else 
-    {
-       printf("(d)dumpLogFile(%d):: seek[%4d/%04d]ID[%8d]->[%s]\r\n", __LINE__, seekToLine, offset, lineID, globalBuff);
-    }
-  } //-- while ..
+} // exportStep()
 
-  return true;
+//-------------------------------------------------------------------------------------
+//-- true if all lines are exported (or no export was started)
+boolean ESPSL::exportDone()
+{
+  return ((_exportStream == NULL) || (_exportNext > _exportEnd));
+
+} // exportDone()
 
-} // dumpLogFile
 
 //-------------------------------------------------------------------------------------
 //-- erase SysLog file from LittleFS
@@ -665,17 +3302,93 @@ boolean ESPSL::removeSysLog()
 #ifdef _DODEBUG
   if (_Debug(1)) printf("ESPSL(%d)::removeSysLog()..\r\n", __LINE__);
 #endif
-  LittleFS.remove(_sysLogFile);
+  _wbCount = 0;   //-- pending lines are gone with the file
+  if (_segBytes > 0)
+  {
+    removeSegments();
+    return true;
+  }
+  _store->close(_fd);
+  _store->remove(_sysLogFile);
   return true;
   
 } // removeSysLog()
 
+//-------------------------------------------------------------------------------------
+//-- copy the counters to stats, returns false if they are compiled out (ESPSL_NO_STATS)
+boolean ESPSL::getStats(ESPSL_stats *stats)
+{
+#ifdef _DOSTATS
+#if defined(ESP32)
+  //-- the writer task updates the counters with the lock taken
+  boolean locked = lock();
+#endif
+  memcpy(stats, &_stats, sizeof(ESPSL_stats));
+  if (stats->write.count        == 0) { stats->write.minMicros        = 0; }
+  if (stats->readNextLine.count == 0) { stats->readNextLine.minMicros = 0; }
+#if defined(ESP32)
+  stats->droppedLines += _aqDropped.load() + _aqOverwritten.load();
+  if (locked) unlock();
+#endif
+  return true;
+#else
+  memset(stats, 0, sizeof(ESPSL_stats));
+  return false;
+#endif
+
+} // getStats()
+
+//-------------------------------------------------------------------------------------
+void ESPSL::resetStats()
+{
+#ifdef _DOSTATS
+#if defined(ESP32)
+  boolean locked = lock();
+#endif
+  memset(&_stats, 0, sizeof(ESPSL_stats));
+  _stats.write.minMicros        = UINT32_MAX;
+  _stats.readNextLine.minMicros = UINT32_MAX;
+#if defined(ESP32)
+  if (locked) unlock();
+#endif
+#endif
+
+} // resetStats()
+
+#ifdef _DOSTATS
+//-------------------------------------------------------------------------------------
+//-- add one call that started at startMicros to latency
+void ESPSL::addLatency(ESPSL_latency *latency, uint32_t startMicros)
+{
+  uint32_t elapsed = micros() - startMicros;
+  uint8_t  bin     = 0;
+
+  if (elapsed > 0) { bin = 32 - __builtin_clz(elapsed); }
+  if (bin >= ESPSL_HISTBINS) { bin = ESPSL_HISTBINS -1; }
+  latency->hist[bin]++;
+  latency->count++;
+  latency->totalMicros += elapsed;
+  if (elapsed < latency->minMicros) { latency->minMicros = elapsed; }
+  if (elapsed > latency->maxMicros) { latency->maxMicros = elapsed; }
+
+} // addLatency()
+#endif
+
 //-------------------------------------------------------------------------------------
 //-- returns ESPSL status info
 void ESPSL::status() 
 {
+#if defined(ESP32)
+  boolean locked = lock();
+#endif
   printf("ESPSL::status():       _numLines[%8d]\r\n", _numLines);
   printf("ESPSL::status():      _lineWidth[%8d]\r\n", _lineWidth);
+  if (_segLines > 0)
+  {
+    if (_segPacked)
+          printf("ESPSL::status():       segments[%8d] of [%d] bytes (packed)\r\n", _numSegs, _segBytes);
+    else  printf("ESPSL::status():       segments[%8d] of [%d] lines\r\n", _numSegs, _segLines);
+  }
   if (_numLines > 0) 
   {
     printf("ESPSL::status():   _oldestLineID[%8d] (%2d)\r\n", _oldestLineID
@@ -684,6 +3397,46 @@ void ESPSL::status()
                                                            , (_lastUsedLineID % _numLines)+1);
   }
   printf("ESPSL::status():       _debugLvl[%8d]\r\n", _debugLvl);
+  printf("ESPSL::status():       _logLevel[%8d]\r\n", _logLevel);
+  if (_wbMaxLines > 0)
+  {
+    printf("ESPSL::status():  pending lines[%8d] (max %d)\r\n", _wbCount, _wbMaxLines);
+  }
+#if defined(ESP32)
+  if (_aqRing != NULL)
+  {
+    ESPSL_asyncStats stats;
+    getAsyncStats(&stats);
+    printf("ESPSL::status():  async queued[%8d] dropped[%d] overwritten[%d] written[%d]\r\n"
+                                    , stats.enqueued, stats.dropped, stats.overwritten, stats.written);
+    printf("ESPSL::status():  async micros[%8d] (max %d)\r\n", stats.avgMicros, stats.maxMicros);
+  }
+#endif
+#ifdef _DOSTATS
+  ESPSL_stats      stats;
+  ESPSL_latency   *latency;
+  const char      *name;
+  getStats(&stats);
+  printf("ESPSL::status():   linesWritten[%8u] bytes[%u] truncated[%u] dropped[%u]\r\n"
+                                    , stats.linesWritten, stats.bytesWritten, stats.truncatedLines, stats.droppedLines);
+  printf("ESPSL::status():          seeks[%8u] flushes[%u] failed writes[%u] suppressed[%u]\r\n"
+                                    , stats.seeks, stats.flushes, stats.failedWrites, stats.suppressedLines);
+  for (int l = 0; l < 2; l++)
+  {
+    latency = (l == 0 ? &stats.write : &stats.readNextLine);
+    name    = (l == 0 ? "write" : "readNextLine");
+    if (latency->count == 0) continue;
+    printf("ESPSL::status(): %14s[%8u] micros min[%u] avg[%u] max[%u]\r\n", name, latency->count
+                                    , latency->minMicros, (uint32_t)(latency->totalMicros / latency->count)
+                                    , latency->maxMicros);
+    printf("ESPSL::status():  < 2^n micros ");
+    for (int b = 0; b < ESPSL_HISTBINS; b++) { printf(" %u", latency->hist[b]); }
+    printf("\r\n");
+  }
+#endif
+#if defined(ESP32)
+  if (locked) unlock();
+#endif
   
 } // status()
 
@@ -723,18 +3476,30 @@ void ESPSL::println(const char *line)
 } // println()
 
 //-------------------------------------------------------------------------------------
+//-- a longer message than fits in lineBuff is formatted in a malloc'ed buffer
 void ESPSL::printf(const char *fmt, ...)
 {
-  char lineBuff[(_MAXLINEWIDTH + 101)];
-  memset(lineBuff, 0, (_MAXLINEWIDTH + 101));
-
+  char    lineBuff[64];
+  char   *line = lineBuff;
+  int     len;
   va_list args;
+
+  if (!_streamOn && !_serialOn) return;
+
   va_start (args, fmt);
-  vsnprintf(lineBuff, (_MAXLINEWIDTH +100), fmt, args);
+  len = vsnprintf(lineBuff, sizeof(lineBuff), fmt, args);
   va_end (args);
+  if ((len >= (int)sizeof(lineBuff)) && ((line = (char*)malloc(len +1)) != NULL))
+  {
+    va_start (args, fmt);
+    vsnprintf(line, (len +1), fmt, args);
+    va_end (args);
+  }
+  if (line == NULL) line = lineBuff;    //-- no heap, print what fits
 
-  if (_streamOn)  _Stream->print(lineBuff);
-  if (_serialOn)  _Serial->print(lineBuff);
+  if (_streamOn)  _Stream->print(line);
+  if (_serialOn)  _Serial->print(line);
+  if (line != lineBuff) free(line);
 
 } // printf()
 
@@ -754,6 +3519,11 @@ boolean ESPSL::checkSysLogFileSize(const char* func, int32_t cSize)
   if (_Debug(4)) printf("ESPSL(%d)::checkSysLogFileSize(%d)..\r\n", __LINE__, cSize);
 #endif
   int32_t fileSize = sysLogFileSize();
+  //-- a sparse sysLog file is complete once every slot has been used
+  if ((_fileFlags & _HDR_SPARSE) && (fileSize >= (int32_t)sizeof(ESPSL_fileHeader)) && (fileSize <= cSize)) 
+  {
+    return true;
+  }
   if (fileSize != cSize) 
   {
     printf("ESPSL(%d)::%s -> [%s] size is [%d] but should be [%d] .. error!\r\n"
@@ -786,6 +3556,78 @@ void ESPSL::setDebugLvl(int8_t debugLvl)
   
 } // setDebugLvl
 
+//-------------------------------------------------------------------------------------
+//-- keep the sysLog file somewhere else than on LittleFS, call before begin()
+void ESPSL::setStorage(ESPSL_Storage *storage)
+{
+  commit();
+  _store->close(_fd);
+  _store->close(_fd ^ 1);
+  _store = (storage != NULL ? storage : &_fsStorage);
+  _fd    = 0;
+  _segOpen[0] = -1;
+  _segOpen[1] = -1;
+  
+} // setStorage()
+
+//-------------------------------------------------------------------------------------
+//-- keep the sysLog in segment files (/sysLog.000, /sysLog.001 ..) of at most
+//-- segmentBytes instead of one /sysLog.dat (0), call before begin(). packed:
+//-- records only take their header and text (segmentBytes max. 65535)
+void ESPSL::setSegments(uint32_t segmentBytes, boolean packed)
+{
+  commit();
+  _store->close(_fd);
+  _store->close(_fd ^ 1);
+  _segOpen[0] = -1;
+  _segOpen[1] = -1;
+  _segBytes   = segmentBytes;
+  _segLines   = 0;
+  _segPacked  = (packed && (segmentBytes > 0));
+  _fd         = 0;
+  freePacked();
+
+} // setSegments()
+
+//-------------------------------------------------------------------------------------
+//-- compress the text of new lines with dictionary (NULL: a built-in one), the
+//-- text the sketch logs (its format strings) is the best dictionary. Off keeps
+//-- the dictionary to read the compressed lines that are already written.
+void ESPSL::setCompression(boolean on, const char *dictionary)
+{
+  free(_lzHash);
+  _lzHash = NULL;
+  _lzOn   = false;
+  if (!on) return;
+
+  _lzDict    = (dictionary != NULL ? dictionary : lzDefaultDict);
+  _lzDictLen = (strlen(_lzDict) < _LZDICTMAX ? strlen(_lzDict) : _LZDICTMAX);
+  _lzDict   += (strlen(_lzDict) - _lzDictLen);    //-- the end is closest to the line
+  _lzTag     = (hash16(_lzDict, _lzDictLen) | 0x0001);
+  _lzHash    = (uint16_t*)calloc(_LZHASHSIZE, sizeof(uint16_t));
+  if (_lzHash == NULL)
+  {
+    printf("ESPSL(%d)::setCompression(): could not allocate [%d] bytes\r\n", __LINE__, (_LZHASHSIZE * sizeof(uint16_t)));
+    return;
+  }
+  for (int pos = 0; (pos +3) <= _lzDictLen; pos++)
+  {
+    _lzHash[lzHash3((const uint8_t*)&_lzDict[pos])] = (pos +1);
+  }
+  _lzOn = true;
+
+} // setCompression()
+
+//-------------------------------------------------------------------------------------
+//-- lines with a higher severity level are not written
+void ESPSL::setLogLevel(uint8_t lvl)
+{
+  if (lvl <= ESPSL_TRACE)
+        _logLevel = lvl;
+  else  _logLevel = ESPSL_TRACE;
+  
+} // setLogLevel
+
 //-------------------------------------------------------------------------------------
 //-- returns debugLvl
 int8_t ESPSL::getDebugLvl()
@@ -799,9 +3641,7 @@ int8_t ESPSL::getDebugLvl()
 //-- returns debugLvl
 boolean ESPSL::_Debug(int8_t Lvl)
 {
-  if (getDebugLvl() > 0 && Lvl <= getDebugLvl()) 
-        return true;
-  else  return false;
+  return (_debugLvl > 0 && Lvl <= _debugLvl);
   
 } // _Debug()
 
@@ -821,140 +3661,27 @@ const char* ESPSL::rtrim(char *aChr)
   return aChr;
 } // rtrim()
 
-//===========================================================================================
-void ESPSL::fixLineWidth(char *inLine, int lineLen) 
-{
-  int16_t newLen;
-  
-#ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::fixLineWidth([%s], %d) ..\r\n", __LINE__, inLine, lineLen);
-#endif
-  char fixLine[(lineLen+1)];
-  memset(fixLine, 0, (lineLen+1));
-
-  //printf("ESPSL(%d)::fixLineWidth(): inLine[%s]\r\n", __LINE__, inLine);
-
-  snprintf(fixLine, lineLen, "%s", inLine);
-  //printf("ESPSL(%d)::fixLineWidth(): fixLine[%s]\r\n", __LINE__, fixLine);
-
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d):: [%s]\r\n", __LINE__, fixLine);
-#endif
-  //-- first: remove control chars
-  for(int i=0; i<strlen(fixLine); i++)
-  {
-    if ((fixLine[i] < ' ') || (fixLine[i] > '~')) { fixLine[i] = '^'; }
-  }
-  //-- add spaces at the end
-  do {
-      strlcat(fixLine, "     ", lineLen);
-      newLen = strlen(fixLine);
-  } while(newLen < (lineLen-1));
-  //printf("ESPSL(%d)::fixLineWidth(): fixLine[%s]\r\n", __LINE__, fixLine);
-  
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d):: [%s]\r\n", __LINE__, fixLine);
-#endif
-
-  memset(inLine, 0, lineLen);
-  strlcpy(inLine, fixLine, lineLen);
-  //printf("ESPSL(%d):: in[%s] -> out[%s] (len[%d])\r\n", __LINE__, fixLine, inLine, lineLen);
-  
-#ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::fixLineWidth(): Length of inLine is [%d] bytes\r\n", __LINE__, strlen(inLine));
-#endif
-  //printf("ESPSL(%d)::fixLineWidth(): inLine[%s]\r\n", __LINE__, inLine);
-  
-} // fixLineWidth()
-
-//===========================================================================================
-void ESPSL::fixRecLen(char *recIn, int32_t recKey, int recLen) 
-{
-  int newLen;
-  
-#ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::fixRecLen([%s], %d, %d) ..\r\n", __LINE__, recIn, recKey, recLen);
-#endif
-  char recOut[(recLen+1)];
-  memset(recOut, 0, (recLen+1));
-
-  snprintf(recOut, recLen, "%010d|%s", recKey, recIn);
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d):: [%s]\r\n", __LINE__, recOut);
-#endif
-  //-- add spaces at the end
-  do {
-      strlcat(recOut, "     ", recLen);
-      newLen = strlen(recOut);
-  } while(newLen < (recLen-1));
-  
-#ifdef _DODEBUG
-  if (_Debug(3)) printf("ESPSL(%d):: [%d]->[%-20.20s]\r\n", __LINE__, recKey, recOut);
-#endif
-
-  strlcpy(recIn, recOut, recLen);
-
-#ifdef _DODEBUG
-  if (_Debug(4)) printf("ESPSL(%d)::fixRecLen(): Length of record is [%d] bytes\r\n", __LINE__, strlen(recIn));
-#endif
-  
-  //printf("ESPSL(%d):: record(%010d)->[%s]\r\n", __LINE__, recKey, recIn);
-  
-} // fixRecLen()
 
 //===========================================================================================
+//-- size of the sysLog file (0 if there is none)
 int32_t  ESPSL::sysLogFileSize()
 {
-#if defined(ESP8266)
+  int32_t fileSize;
+
+  if (_store->isOpen(_fd)) 
   {
-    Dir dir = LittleFS.openDir("/");         // List files on LittleFS
-    while (dir.next())  {
-          yield();
-          String fileName = dir.fileName();
-          size_t fileSize = dir.fileSize();
-#ifdef _DODEBUG
-          if (_Debug(6)) printf("ESPSL)%d)::sysLogFileSize(): found: %s, size: %d\r\n"
-                                                                             , __LINE__
-                                                                             , fileName.c_str()
-                                                                             , fileSize);
-#endif
-          if (fileName == _sysLogFile) {
-#ifdef _DODEBUG
-            if (_Debug(6)) printf("ESPSL(%d)::sysLogFileSize(): fileSize[%d]\r\n", __LINE__, fileSize);
-#endif
-            //dir.close();
-            return (int32_t)fileSize;
-          }
-    }
-  //dir.close();
-  return 0;
+    fileSize = _store->size(_fd);
   }
-#else
+  else
   {
-      File root = LittleFS.open("/");
-      File file = root.openNextFile();
-      while(file)
-      {
-          String tmpS = file.name();
-          String fileName = "/"+tmpS;
-          size_t fileSize = file.size();
-#ifdef _DODEBUG
-          if (_Debug(4)) printf("ESPSL(%d)::FS Found: %s, size: %d\n", __LINE__, fileName.c_str(), fileSize);
-#endif
-          if (fileName == _sysLogFile) 
-          {
-#ifdef _DODEBUG
-            if (_Debug(4)) printf("ESPSL(%d)::sysLogFileSize(): fileSize[%d]\r\n", __LINE__, fileSize);
-#endif
-            printf("ESPSL(%d)::sysLogFileSize(): file is still [%d]bytes\r\n", __LINE__, (int32_t)fileSize);
-            return (int32_t)fileSize;
-          }
-          file = root.openNextFile();
-      }
-      return 0;
+    if (!_store->open(_fd, _sysLogFile, false)) return 0;
+    fileSize = _store->size(_fd);
+    _store->close(_fd);
   }
-
+#ifdef _DODEBUG
+  if (_Debug(4)) printf("ESPSL(%d)::sysLogFileSize(): fileSize[%d]\r\n", __LINE__, fileSize);
 #endif
+  return (fileSize < 0 ? 0 : fileSize);
 
 } // sysLogFileSize()
 
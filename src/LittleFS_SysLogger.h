@@ -13,18 +13,155 @@
 
 #include <FS.h>
 #include <LittleFS.h>
+#include <time.h>
+#include "ESPSL_Storage.h"
+#if defined(ESP32)
+  #include <atomic>
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+  #include <freertos/semphr.h>
+#endif
+
+//-- first bytes of the sysLog file
+struct ESPSL_fileHeader {
+  char        magic[4];       // "ESPL"
+  uint8_t     version;
+  uint8_t     flags;
+  uint16_t    lineWidth;
+  uint32_t    numLines;
+  uint32_t    lastLineID;     // last used lineID when the header was written
+};
+
+//-- every slot starts with this header, followed by 'len' bytes of text
+//-- (packed: in a chunk of slots it is only 4-byte aligned if lineWidth is)
+struct __attribute__((packed)) ESPSL_recHeader {
+  uint32_t    lineID;         // 0 or 0xFFFFFFFF is an empty slot
+  uint32_t    timeStamp;      // epoch
+  uint8_t     len;
+  uint8_t     flags;
+  uint16_t    crc;            // CRC-16 of header (crc = 0) and text
+};
+
+//-- severity of a log line (stored in the record flags)
+#define ESPSL_NONE      0
+#define ESPSL_ERROR     1
+#define ESPSL_WARN      2
+#define ESPSL_INFO      3
+#define ESPSL_DEBUG     4
+#define ESPSL_TRACE     5
+
+//-- lines above this level are removed at compile time (including the
+//-- evaluation of their arguments), define it before including this file
+#ifndef ESPSL_LOG_LEVEL
+  #define ESPSL_LOG_LEVEL   ESPSL_TRACE
+#endif
+
+constexpr bool ESPSL_levelEnabled(uint8_t lvl) { return (lvl <= ESPSL_LOG_LEVEL); }
+
+//-- the runtime level (setLogLevel()) is checked before anything is formatted
+#define ESPSL_LOG(obj, lvl, ...)          do { if (ESPSL_levelEnabled(lvl) && (obj).levelOn(lvl))        \
+                                                 { (obj).writeLvl((lvl), __VA_ARGS__); } } while(0)
+#define ESPSL_LOG_DBG(obj, lvl, dbg, ...) do { if (ESPSL_levelEnabled(lvl) && (obj).levelOn(lvl))        \
+                                                 { (obj).writeDbgLvl((lvl), (dbg), __VA_ARGS__); } } while(0)
+
+#define ESPSL_LOG_E(obj, ...)   ESPSL_LOG(obj, ESPSL_ERROR, __VA_ARGS__)
+#define ESPSL_LOG_W(obj, ...)   ESPSL_LOG(obj, ESPSL_WARN,  __VA_ARGS__)
+#define ESPSL_LOG_I(obj, ...)   ESPSL_LOG(obj, ESPSL_INFO,  __VA_ARGS__)
+#define ESPSL_LOG_D(obj, ...)   ESPSL_LOG(obj, ESPSL_DEBUG, __VA_ARGS__)
+#define ESPSL_LOG_T(obj, ...)   ESPSL_LOG(obj, ESPSL_TRACE, __VA_ARGS__)
+
+//-- what writeAsync() does when the ring is full (ESP32 only)
+#define ESPSL_Q_DROP        0     // the new line is dropped
+#define ESPSL_Q_BLOCK       1     // wait until the writer task made room
+#define ESPSL_Q_OVERWRITE   2     // the oldest line in the ring is dropped
+
+//-- counters of the writer task (getAsyncStats())
+struct ESPSL_asyncStats {
+  uint32_t    enqueued;
+  uint32_t    dropped;        // ESPSL_Q_DROP
+  uint32_t    overwritten;    // ESPSL_Q_OVERWRITE
+  uint32_t    written;        // by the writer task
+  uint32_t    avgMicros;      // time spent in writeAsync()
+  uint32_t    maxMicros;
+};
+
+//-- flags for ESPSL::find()
+#define ESPSL_FIND_FORWARD  0x00    // oldest line first
+#define ESPSL_FIND_BACKWARD 0x01    // newest line first
+
+//-- latency of one method in micro seconds, hist[n] counts the calls that took
+//-- less than 2^n micros (hist[0]: 0 micros), the last bin counts the rest
+#define ESPSL_HISTBINS  16
+struct ESPSL_latency {
+  uint32_t    count;
+  uint32_t    minMicros;
+  uint32_t    maxMicros;
+  uint64_t    totalMicros;
+  uint32_t    hist[ESPSL_HISTBINS];
+};
+
+//-- counters of the sysLog file (getStats()), define ESPSL_NO_STATS to leave them out
+struct ESPSL_stats {
+  uint32_t        linesWritten;
+  uint32_t        bytesWritten;
+  uint32_t        seeks;            // reads/writes not where the previous one ended
+  uint32_t        flushes;
+  uint32_t        failedWrites;
+  uint32_t        droppedLines;     // writeAsync(), full write-behind buffer (commit() failed)
+  uint32_t        truncatedLines;   // longer than lineWidth
+  uint32_t        suppressedLines;  // repeats (setSuppressRepeats())
+  ESPSL_latency   write;            // write(), writef(), writeDbg() ..
+  ESPSL_latency   readNextLine;
+};
+
+//-- called by ESPSL::readLines() (and find(), readRange()) for every line, return false to stop
+typedef bool (*ESPSL_lineVisitor)(uint32_t lineID, uint32_t timeStamp, const char *line, void *ctx);
 
 class ESPSL {
 
+#ifndef ESPSL_NO_DEBUG
   #define _DODEBUG
+#endif
+#ifndef ESPSL_NO_STATS
+  #define _DOSTATS
+  #define _STAT(x)  x
+#else
+  #define _STAT(x)
+#endif
   #define _MAXLINEWIDTH 150
   #define _MINLINEWIDTH  50
   #define _MINNUMLINES   10
-  #define _KEYLEN        11
   #define _EMPTYID       -1
+  #define _ERASEDID      0xFFFFFFFF   // lineID in a slot on erased flash
+  #define _FILEMAGIC     "ESPL"
+  #define _FILEVERSION    1
+  #define _FILE_UNKNOWN   0       // fileType(): not a sysLog file (empty, torn header)
+  #define _FILE_VERSION   1       // fileType(): a binary sysLog file of another version
+  #define _FILE_ASCII     2       // fileType(): an old text sysLog file
+  #define _READCHUNK     1024     // bytes read from the sysLog file at once
+  #define _FLAG_LEVEL    0x07     // record flags: severity
+  #define _FLAG_DEFERRED 0x08     // record flags: text is format pointer + raw args
+  #define _FLAG_CRC      0x10     // record flags: crc is set
+  #define _FLAG_TRUNC    0x20     // record flags: text was longer than _lineWidth
+  #define _FLAG_LZ       0x40     // record flags: text is compressed (setCompression())
+  #define _CURSOREVERY     32     // lines between cursor updates in the file header
+  #define _HDR_SPARSE    0x01     // file header flags: slots are written when they are used
+  #define _HDR_SEGMENT   0x02     // file header flags: one segment of a segmented sysLog
+  #define _HDR_PACKED    0x04     // file header flags: records in the segment are packed
+  #define _SEGFILE       "/sysLog.%03d"   // segment files (setSegments())
+  #define _SEGNAMELEN      24     // "/sysLog." + any int + '\0' (segmentName())
+  #define _MAXSEGMENTS   1000
+  #define _IDXEVERY         8     // packed segments: records between index entries
+  #define _LZMAXMATCH      18     // compressed text: longest copy
+  #define _LZMAXOFFSET   2048     // compressed text: furthest copy back (dictionary + line)
+  #define _LZDICTMAX     (_LZMAXOFFSET - _MAXLINEWIDTH)
+  #define _LZHASHSIZE     256
   
 public:
   ESPSL();
+  ~ESPSL();
+  ESPSL(const ESPSL&) = delete;
+  ESPSL &operator=(const ESPSL&) = delete;
 
   boolean   begin(uint16_t depth,  uint16_t lineWidth);
   boolean   begin(uint16_t depth,  uint16_t lineWidth, boolean mode);
@@ -33,15 +170,52 @@ public:
   boolean   writef(const char *fmt, ...);
   char     *buildD(const char *fmt, ...);
   boolean   writeDbg(const char *dbg, const char *fmt, ...);
+  boolean   writeLvl(uint8_t lvl, const char *fmt, ...);
+  boolean   writeDbgLvl(uint8_t lvl, const char *dbg, const char *fmt, ...);
+  void      setLogLevel(uint8_t lvl);
+  boolean   writeDeferred(const char *fmt, ...);
+  inline boolean levelOn(uint8_t lvl) { return (lvl <= _logLevel); }
   void      startReading();    // Returns last line read
   bool      readNextLine(char *lineOut, int lineOutLen);
   bool      readPreviousLine(char *lineOut, int lineOutLen);
+  int32_t   readLines(int32_t fromLineID, int32_t maxLines, ESPSL_lineVisitor visitor, void *ctx);
+  int32_t   readSince(int32_t lastSeenID, ESPSL_lineVisitor visitor, void *ctx
+                                    , int32_t maxLines = 0, uint32_t *missedLines = NULL);
+  int32_t   seekToTime(uint32_t t);
+  int32_t   find(const char *pattern, ESPSL_lineVisitor visitor, void *ctx
+                                    , uint8_t flags = ESPSL_FIND_FORWARD, int32_t maxHits = 0);
+  int32_t   readRange(uint32_t tStart, uint32_t tEnd, ESPSL_lineVisitor visitor, void *ctx);
   bool      dumpLogFile();
+  void      beginExport(Stream &exportTo, boolean throttle = true);
+  int32_t   exportStep(uint16_t maxLines, uint32_t budgetMicros);
+  boolean   exportDone();
   boolean   removeSysLog();
   uint32_t  getLastLineID();
   void      setOutput(HardwareSerial *serIn, int baud);
   void      setOutput(Stream *serIn);
   void      setDebugLvl(int8_t debugLvl);
+  void      setStorage(ESPSL_Storage *storage);
+  void      setSegments(uint32_t segmentBytes, boolean packed = false);
+  void      setCompression(boolean on, const char *dictionary = NULL);
+  void      setBuffered(uint16_t maxLines, uint32_t maxBytes, uint32_t maxAgeMs);
+  void      setLazyCreate(boolean lazy);
+  void      setFlushEveryLine(boolean flushEveryLine);
+  void      setSuppressRepeats(boolean suppress, uint8_t skipPrefix = 0, uint32_t timeoutMs = 0);
+  boolean   getStats(ESPSL_stats *stats);
+  void      resetStats();
+  boolean   commit();
+  void      loop();
+#if defined(ESP32)
+  boolean   startWriter(uint16_t ringSize, uint8_t fullPolicy, UBaseType_t priority = 1, BaseType_t core = tskNO_AFFINITY);
+  void      stopWriter();
+  boolean   writeAsync(const char *fmt, ...);
+  void      getAsyncStats(ESPSL_asyncStats *stats);
+  boolean   lock(uint32_t waitMs = 1000);
+  void      unlock();
+#endif
+
+protected:
+  ESPSL(char *textBuff, uint8_t *recBuff, uint8_t *workBuff, uint16_t bufWidth);
     
 private:
 
@@ -51,26 +225,167 @@ private:
   boolean         _streamOn;
   boolean         _serialOn;
 
-  File        _sysLog;
-  char        globalBuff[_MAXLINEWIDTH +15];
+  ESPSL_FSStorage _fsStorage;     // LittleFS, unless setStorage() is used
+  ESPSL_Storage  *_store;
+  uint8_t     _fd;                // the sysLog file (the other one is for resizeLog())
+  uint32_t    _filePos;           // where the next readFile()/writeFile() starts
+  char       *globalBuff;         // _bufWidth +15 chars
+  uint8_t    *_recBuff;           // one record of _bufWidth chars +1
+  uint8_t    *_workBuff;          // one record of _bufWidth chars +1 (a copy, (un)packed text)
+  uint16_t    _bufWidth;          // widest line the buffers can hold
+  boolean     _ownBuffs = false;  // the buffers are malloc'ed by ESPSL()
   int32_t     _lastUsedLineID;
   int32_t     _oldestLineID;
   int32_t     _numLines;
   int32_t     _lineWidth;
-  int32_t     _recLength;
+  int32_t     _recLength;         // bytes per slot (header + text)
   int32_t     _readNext;
   int32_t     _readNextEnd;
   int32_t     _readPrevious;
   int32_t     _readPreviousEnd;
+  int32_t     _cursorLineID;
+  uint8_t     _fileFlags  = 0;
+  boolean     _lazyCreate = false;
+  boolean     _flushEveryLine = true;
+
+  //-- segment files (setSegments())
+  uint32_t    _segBytes = 0;      // max. size of a segment file, 0: one sysLog file
+  int32_t     _segLines = 0;      // slots per segment file
+  int32_t     _numSegs  = 0;
+  int32_t     _segOpen[ESPSL_MAXFILES] = { -1, -1 };  // segment open on fd
+  boolean     _segPacked = false; // records only take their header and text
+  int32_t    *_segFirst  = NULL;  // packed: first lineID of every segment (0: none)
+  uint16_t   *_pkIndex[ESPSL_MAXFILES] = { NULL, NULL };  // packed: offset of every _IDXEVERY'th record
+  int32_t     _pkCount[ESPSL_MAXFILES] = { 0, 0 };        // packed: records in the segment on fd
+  uint32_t    _pkEnd     = 0;     // packed: offset of the next record in the segment on _fd
+  uint8_t    *_pkRec     = NULL;  // packed: last record read (zero padded to _recLength)
+  int32_t     _pkRecID   = 0;
+  int32_t     _pkWalkSeg = -1;    // packed: the record after _pkRec, next read is no lookup
+  int32_t     _pkWalkID  = 0;
+  uint32_t    _pkWalkOff = 0;
+
+  //-- compressed records (setCompression())
+  boolean     _lzOn      = false;
+  const char *_lzDict    = NULL;  // NULL: built-in dictionary
+  uint16_t    _lzDictLen = 0;
+  uint16_t    _lzTag     = 0;     // identifies the dictionary in a compressed record (2 bytes)
+  uint16_t   *_lzHash    = NULL;  // last position in the dictionary of every 3 char hash
+
+  //-- repeated lines (setSuppressRepeats())
+  boolean     _dupSuppress = false;
+  uint8_t     _dupSkip     = 0;
+  uint32_t    _dupTimeout  = 0;
+  uint32_t    _dupHash     = 0;
+  uint8_t     _dupLen      = 0;
+  uint8_t     _dupFlags    = 0;
+  uint32_t    _dupCount    = 0;
+  uint32_t    _dupStart    = 0;
+#ifdef _DOSTATS
+  ESPSL_stats _stats;
+  uint32_t    _statStart = 0;
+#endif
+
+  //-- incremental export (beginExport())
+  Stream     *_exportStream;
+  boolean     _exportThrottle;
+  int32_t     _exportNext;
+  int32_t     _exportEnd;
   int8_t      _debugLvl = 0;
+  uint8_t     _logLevel = ESPSL_TRACE;
+  uint16_t    _fwTag    = 0;
+
+  //-- write-behind buffer (setBuffered())
+  uint8_t    *_wbBuff;
+  uint16_t    _wbMaxLines;
+  uint16_t    _wbCount;
+  uint32_t    _wbMaxBytes;
+  uint32_t    _wbMaxAge;
+  uint32_t    _wbStart;
+
+#if defined(ESP32)
+  //-- MPSC ring + writer task (startWriter())
+  struct ESPSL_asyncCell {
+    std::atomic<uint32_t> seq;
+    uint8_t               rec[sizeof(ESPSL_recHeader) + _MAXLINEWIDTH +1];
+  };
+  ESPSL_asyncCell        *_aqRing  = NULL;
+  uint32_t                _aqMask  = 0;
+  uint8_t                 _aqPolicy = ESPSL_Q_DROP;
+  std::atomic<uint32_t>   _aqHead{0};
+  std::atomic<uint32_t>   _aqTail{0};
+  std::atomic<uint32_t>   _aqEnqueued{0};
+  std::atomic<uint32_t>   _aqDropped{0};
+  std::atomic<uint32_t>   _aqOverwritten{0};
+  std::atomic<uint32_t>   _aqWritten{0};
+  std::atomic<uint32_t>   _aqMicros{0};
+  std::atomic<uint32_t>   _aqMaxMicros{0};
+  std::atomic<int32_t>    _aqWidth{_MINLINEWIDTH};   // lineWidth for writeAsync()
+  std::atomic<boolean>    _aqRun{false};
+  std::atomic<TaskHandle_t> _aqTask{NULL};
+  SemaphoreHandle_t       _aqLock  = NULL;    // recursive mutex
+
+  static void asyncWriter(void *param);
+  ESPSL_asyncCell *claimAsync(uint32_t *pos);
+  boolean     dequeueAsync(uint8_t *recOut);
+  void        drainAsync();
+#endif
   
-  boolean     create(uint16_t depth, uint16_t lineWidth);
+  boolean     create(uint16_t depth, uint16_t lineWidth, const char *fileName = NULL);
   boolean     init();
   const char *rtrim(char *);
   boolean     checkSysLogFileSize(const char* func, int32_t cSize);
+  int32_t     fileSize();
+  uint32_t    slotOffset(int32_t slot);
+  boolean     seekSlot(int32_t slot);
+  boolean     seekFile(uint32_t offset);
+  int32_t     readFile(uint8_t *data, size_t len);
+  size_t      writeFile(const uint8_t *data, size_t len);
+  void        syncFile();
+  boolean     beginSegments(uint16_t depth, uint16_t lineWidth);
+  const char *segmentName(int32_t seg, char *segName);
+  boolean     openSegment(uint8_t fd, int32_t seg, int32_t firstID);
+  int32_t     segmentIO(uint8_t *data, size_t len, boolean doWrite);
+  void        removeSegments();
+  boolean     allocPacked();
+  void        freePacked();
+  void        scanPacked(uint8_t fd, int32_t seg);
+  int32_t     packedSegment(int32_t lineID);
+  boolean     readPacked(int32_t lineID);
+  size_t      appendPacked(const uint8_t *rec);
+  int32_t     packedIO(uint8_t *data, size_t len, boolean doWrite);
+#ifdef _DOSTATS
+  void        addLatency(ESPSL_latency *latency, uint32_t startMicros);
+#endif
+  void        buildRecord(uint8_t *recOut, int32_t lineID, const char *text);
+  void        formatRecord(uint8_t *recOut, int32_t lineID, const char *prefix, const char *fmt, va_list args
+                                                                         , int32_t lineWidth);
+  void        deferRecord(uint8_t *recOut, int32_t lineID, const char *fmt, va_list args);
+  void        expandText(ESPSL_recHeader *recHdr, char *text);
+  uint16_t    firmwareTag();
+  void        sealRecord(uint8_t *rec);
+  void        packText(uint8_t *rec);
+  boolean     unpackText(ESPSL_recHeader *recHdr, char *text);
+  boolean     writeRecord();
+  boolean     storeRecord();
+  void        keepPending(int32_t lineID);
+  boolean     isRepeat();
+  boolean     writeRepeats();
+  const uint8_t *pendingRecord(int32_t slot);
+  int32_t     readSlot(int32_t slot, ESPSL_recHeader *recHdr, char *text);
+  int32_t     readSlotID(int32_t slot);
+  int32_t     readValidID(int32_t slot);
+  void        clearSlot(int32_t slot);
+  int32_t     readChunk(int32_t slot, int32_t numSlots, uint8_t *chunk);
+  int32_t     oldestLineID();
+  uint32_t    readTimeStamp(int32_t lineID);
+  int32_t     findTime(uint32_t t);
+  boolean     readMetaData();
+  uint8_t     fileType();
+  boolean     writeMetaData();
+  boolean     migrateAsciiLog();
+  boolean     resizeLog(uint16_t depth, uint16_t lineWidth);
+  int32_t     findLastUsedLineID();
   int32_t     sysLogFileSize();
-  void        fixLineWidth(char *inLine, int lineLen);
-  void        fixRecLen(char *inLine, int32_t key, int recLen);
   void        print(const char*);
   void        println(const char*);
   void        printf(const char *fmt, ...);
@@ -80,6 +395,35 @@ private:
 
 };
 
+//-------------------------------------------------------------------------------------
+//-- ESPSL with the geometry fixed at compile time:
+//--      ESPSL_Fixed<100, 60> sysLog;   ..   sysLog.begin();
+//-- the line and record buffers are part of the object and exactly Width wide
+//-- (ESPSL allocates them for _MAXLINEWIDTH), a wrong geometry does not compile
+template <uint16_t Depth, uint16_t Width>
+class ESPSL_Fixed : public ESPSL {
+
+  static_assert(Depth >= _MINNUMLINES,  "ESPSL_Fixed: Depth must be at least _MINNUMLINES (10)");
+  static_assert(Width >= _MINLINEWIDTH, "ESPSL_Fixed: Width must be at least _MINLINEWIDTH (50)");
+  static_assert(Width <= _MAXLINEWIDTH, "ESPSL_Fixed: Width can not be more than _MAXLINEWIDTH (150)");
+
+public:
+  static constexpr uint16_t depth     = Depth;
+  static constexpr uint16_t lineWidth = Width;
+  static constexpr uint32_t recLength = sizeof(ESPSL_recHeader) + Width;
+
+  ESPSL_Fixed() : ESPSL(_textBuff, _recStore, _workStore, Width) { }
+
+  boolean   begin()             { return ESPSL::begin(Depth, Width); }
+  boolean   begin(boolean mode) { return ESPSL::begin(Depth, Width, mode); }
+
+private:
+  char        _textBuff[Width +15];
+  uint8_t     _recStore[recLength +1];
+  uint8_t     _workStore[recLength +1];
+
+};
+
 #endif
 
 /***************************************************************************